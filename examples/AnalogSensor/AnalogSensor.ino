@@ -0,0 +1,87 @@
+#include <ArduinoJson.h>
+#include <DNSServer.h>
+#include <ESP8266HTTPClient.h>
+#include <ESP8266mDNS.h>
+#include <ESP8266SSDP.h>
+#include <ESP8266WebServer.h>
+#include <ESP8266WiFi.h>
+#include <FS.h>
+#include <LinkedList.h>
+#include <RADESP8266.h>
+#include <WiFiUdp.h>
+
+
+// WiFi Config
+const char* ssid = "YOUR_SSID";
+const char* pass = "YOUR_PASSWORD";
+
+
+// RAD variables
+RADConnector rad("MyESP");
+RADFeature light_1(SensorMultiLevel, "light_1");
+RADFeature motion_1(SensorBinary, "motion_1");
+const int MOTION_PIN = 5;
+
+
+// Sampling configuration for the analog light sensor
+const unsigned long LIGHT_INTERVAL = 50;
+const uint8_t LIGHT_DEADBAND = 4;
+const uint8_t LIGHT_HYSTERESIS = 2;
+const unsigned long LIGHT_DEBOUNCE = 200;
+
+// Sampling configuration for the motion sensor
+const unsigned long MOTION_INTERVAL = 20;
+const unsigned long MOTION_DEBOUNCE = 100;
+
+
+uint8_t light_1_read(void) {
+  // Scale the 10-bit ADC reading down to a single byte
+  return analogRead(A0) >> 2;
+}
+
+
+bool motion_1_read(void) {
+  return digitalRead(MOTION_PIN) == HIGH;
+}
+
+
+void setup() {
+  pinMode(MOTION_PIN, INPUT);
+
+  // Wait 1 second before starting Serial
+  delay(1000);
+  Serial.begin(115200);
+  Serial.println("Starting...");
+
+  // We start by connecting to a WiFi network
+  WiFi.begin(ssid, pass);
+
+  Serial.println();
+  Serial.println();
+  Serial.print("Connecting to ");
+  Serial.println(ssid);
+
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(500);
+    Serial.print(".");
+  }
+
+  Serial.println("");
+  Serial.println("WiFi connected");
+  Serial.println("IP address: ");
+  Serial.println(WiFi.localIP());
+
+  // Create the devices here, State events are sent by the library whenever
+  // a reading changes significantly
+  rad.add(&light_1);
+  light_1.sample(light_1_read, LIGHT_INTERVAL, LIGHT_DEADBAND, LIGHT_HYSTERESIS, LIGHT_DEBOUNCE);
+  light_1.history();
+  rad.add(&motion_1);
+  motion_1.sample(motion_1_read, MOTION_INTERVAL, MOTION_DEBOUNCE);
+  rad.begin();
+}
+
+
+void loop() {
+  rad.update();
+}
@@ -112,6 +112,9 @@ void setup() {
   rad.add(&switch_1);
   switch_1.callback(Set, switch_1_on_set);
   switch_1.callback(Get, switch_1_on_get);
+  // Slow actuators can answer a bool or byte Set with 202 and run it from
+  // rad.update()
+  // switch_1.deferred();
   rad.begin();
 
   // Setup the momentary push button pin
@@ -0,0 +1,844 @@
+// RAD-ESP8266 host benchmark suite.
+//
+// Builds the library against the stand-ins in stubs/ and replays mixed
+// workloads through the same entry points a device uses: requests are
+// injected into the web server and served from RADConnector::update(),
+// events are sent with RADFeature::send() to local callback sinks.
+//
+// Usage: rad-bench [--ops N] [--quick] [--json FILE]
+
+#include <RADESP8266.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <ucontext.h>
+
+
+// Allocation counting
+
+static size_t _allocations = 0;
+static size_t _live = 0;
+static size_t _failures = 0;
+
+extern "C" {
+  void* __real_malloc(size_t size);
+  void* __real_calloc(size_t count, size_t size);
+  void* __real_realloc(void* ptr, size_t size);
+  void __real_free(void* ptr);
+
+  void* __wrap_malloc(size_t size) { _allocations += 1; _live += 1; return __real_malloc(size); }
+  void* __wrap_calloc(size_t count, size_t size) { _allocations += 1; _live += 1; return __real_calloc(count, size); }
+  void* __wrap_realloc(void* ptr, size_t size) {
+    _allocations += 1;
+    _live += ptr == NULL;
+    return __real_realloc(ptr, size);
+  }
+  void __wrap_free(void* ptr) { _live -= ptr != NULL; __real_free(ptr); }
+}
+
+void* operator new(size_t size) { _allocations += 1; _live += 1; return __real_malloc(size); }
+void* operator new[](size_t size) { _allocations += 1; _live += 1; return __real_malloc(size); }
+void operator delete(void* ptr) noexcept { _live -= ptr != NULL; __real_free(ptr); }
+void operator delete[](void* ptr) noexcept { _live -= ptr != NULL; __real_free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { _live -= ptr != NULL; __real_free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { _live -= ptr != NULL; __real_free(ptr); }
+
+
+// Results
+
+struct Result {
+  std::string scenario;
+  int features;
+  int subscriptions;
+  int ops;
+  double p50;
+  double p99;
+  double mean;
+  double throughput;
+  double allocations;
+  size_t failures;
+  size_t stack;
+};
+
+static std::vector<Result> _results;
+static int _ops = 2000;
+
+
+static double percentile(std::vector<double>& samples, double p) {
+  size_t i = (size_t)(p * (samples.size() - 1));
+  return samples[i];
+}
+
+
+template<typename F>
+static void measure(const char* scenario, int features, int subscriptions, F op, int count = 0) {
+  int ops = count > 0 && count < _ops ? count : _ops;
+  std::vector<double> samples;
+  samples.reserve(ops);
+  // Warm up
+  for(int i = 0; i < ops / 10; i++) {
+    op(i);
+  }
+  size_t allocations = _allocations;
+  size_t failures = _failures;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for(int i = 0; i < ops; i++) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    op(i);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+  }
+  double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  allocations = _allocations - allocations;
+
+  Result r;
+  r.scenario = scenario;
+  r.features = features;
+  r.subscriptions = subscriptions;
+  r.ops = ops;
+  std::sort(samples.begin(), samples.end());
+  r.p50 = percentile(samples, 0.50);
+  r.p99 = percentile(samples, 0.99);
+  r.mean = total * 1e6 / ops;
+  r.throughput = ops / total;
+  r.allocations = (double)allocations / ops;
+  r.failures = _failures - failures;
+  r.stack = 0;
+  _results.push_back(r);
+  fprintf(stderr, "%-22s f=%-4d s=%-5d p50=%9.2fus p99=%9.2fus %10.0f op/s %7.2f allocs/op %zu failed\n",
+          scenario, features, subscriptions, r.p50, r.p99, r.throughput, r.allocations, r.failures);
+}
+
+
+// Stack high-water mark
+
+static const size_t STACK_SIZE = 256 * 1024;
+static const uint8_t STACK_PAINT = 0xa5;
+static std::function<void(void)> _stackOp;
+
+static void stack_entry(void) {
+  _stackOp();
+}
+
+
+// Runs op once on a freshly painted stack of its own and records the deepest
+// byte it touched against the last result
+template<typename F>
+static void measure_stack(F op) {
+  std::vector<uint8_t> stack(STACK_SIZE, STACK_PAINT);
+  ucontext_t caller, callee;
+  getcontext(&callee);
+  callee.uc_stack.ss_sp = stack.data();
+  callee.uc_stack.ss_size = stack.size();
+  callee.uc_link = &caller;
+  _stackOp = [&]() { op(0); };
+  makecontext(&callee, stack_entry, 0);
+  swapcontext(&caller, &callee);
+  size_t untouched = 0;
+  while(untouched < stack.size() && stack[untouched] == STACK_PAINT) {
+    untouched++;
+  }
+  _results.back().stack = stack.size() - untouched;
+  fprintf(stderr, "%-22s stack high-water %zu bytes\n", _results.back().scenario.c_str(), _results.back().stack);
+}
+
+
+// Device fixture
+
+static bool _state = false;
+static size_t _delivered = 0;
+
+
+static bool feature_set(bool value) {
+  _state = value;
+  return true;
+}
+
+
+static RADPayload* feature_get(void) {
+  return RADConnector::BuildPayload(_state);
+}
+
+
+struct Fixture {
+  RADConnector* rad;
+#if RAD_ASYNC_SERVER
+  std::shared_ptr<WiFiPipe> connection;
+#else
+  ESP8266WebServer* http;
+#endif
+#if RAD_WEBSOCKET
+  std::shared_ptr<WiFiPipe> socket;
+#endif
+  std::vector<RADFeature*> features;
+  std::vector<std::string> ids;
+  std::vector<std::string> callbacks;
+  std::string response;
+  int expect;
+
+  Fixture(int feature_count, int subscription_count, const char* prefix = "feature_",
+          const char* name = NULL) {
+    SPIFFS.format();
+    rad = new RADConnector("bench");
+    // Admission control is measured on its own, every other scenario floods
+    // the device from a single client on purpose
+    rad->limit(0, 0, 0, 0);
+    expect = 0;
+    ids.reserve(feature_count);
+    for(int i = 0; i < feature_count; i++) {
+      ids.push_back(prefix + std::to_string(i));
+      RADFeature* feature = new RADFeature(SwitchBinary, ids.back().c_str(), name);
+      feature->callback(Set, feature_set);
+      feature->callback(Get, feature_get);
+      features.push_back(feature);
+      rad->add(feature);
+    }
+    rad->begin();
+#if RAD_ASYNC_SERVER
+    // A single keep-alive connection carries every request
+    connection = std::make_shared<WiFiPipe>();
+    connection->remote = IPAddress(192, 168, 1, 10);
+    WiFiServer::listening(RAD_HTTP_PORT)->accept(WiFiClient(connection));
+#else
+    http = ESP8266WebServer::active();
+#endif
+#if RAD_WEBSOCKET
+    socket = std::make_shared<WiFiPipe>();
+    socket->remote = IPAddress(192, 168, 1, 10);
+    WiFiServer::listening(RAD_WEBSOCKET_PORT)->accept(WiFiClient(socket));
+    std::string upgrade = "GET / HTTP/1.1\r\nHost: bench\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    socket->rx.insert(socket->rx.end(), upgrade.begin(), upgrade.end());
+    rad->update();
+    if(socket->tx.compare(0, 12, "HTTP/1.1 101") != 0) {
+      _failures += 1;
+    }
+    socket->tx.clear();
+#endif
+    for(int i = 0; i < subscription_count; i++) {
+      callbacks.push_back(callback(i));
+      rad->subscribe(features[i % feature_count], State, callbacks.back().c_str(), 3600);
+    }
+  }
+
+  static std::string callback(int i) {
+    return "http://10.0." + std::to_string(i % RAD_MAX_CALLBACK_HOSTS) + ".1:8080/notify/" + std::to_string(i);
+  }
+
+#if RAD_ASYNC_SERVER
+  void write(HTTPMethod method, const char* uri, const std::string& body) {
+    std::string raw = std::string(method == HTTP_GET ? "GET " : "POST ") + uri +
+                      " HTTP/1.1\r\nHost: bench\r\nContent-Length: " + std::to_string(body.size()) +
+                      "\r\n\r\n" + body;
+    connection->rx.insert(connection->rx.end(), raw.begin(), raw.end());
+  }
+
+  // Serve requests until count responses have been read back
+  void read(int count) {
+    std::string& tx = connection->tx;
+    while(count > 0 && connection->open) {
+      rad->update();
+      size_t end;
+      while(count > 0 && (end = tx.find("\r\n\r\n")) != std::string::npos) {
+        size_t length = 0;
+        size_t header = tx.find("Content-Length: ");
+        if(header != std::string::npos && header < end) {
+          length = atoi(tx.c_str() + header + 16);
+        }
+        if(tx.size() < end + 4 + length) break;
+        if(!expected(atoi(tx.c_str() + 9))) {
+          _failures += 1;
+        }
+        response = tx.substr(end + 4, length);
+        tx.erase(0, end + 4 + length);
+        count -= 1;
+      }
+    }
+    _failures += count;
+  }
+
+  void request(HTTPMethod method, const char* uri, const std::string& body) {
+    write(method, uri, body);
+    read(1);
+  }
+#else
+  void request(HTTPMethod method, const char* uri, const std::string& body) {
+    WebRequest r;
+    r.method = method;
+    r.uri = uri;
+    r.body = body.c_str();
+    r.remote = IPAddress(192, 168, 1, 10);
+    http->inject(r);
+    rad->update();
+    if(!expected(http->response().code)) {
+      _failures += 1;
+    }
+    response = http->response().body.c_str();
+  }
+#endif
+
+#if RAD_WEBSOCKET
+  // Sends one masked frame and waits for the reply frame, whose status is
+  // bytes 2-3 of a binary reply or the "status" member of a text one
+  void frame(bool binary, const std::string& payload) {
+    static const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+    std::deque<uint8_t>& rx = socket->rx;
+    rx.push_back(0x80 | (binary ? 2 : 1));
+    if(payload.size() < 126) {
+      rx.push_back(0x80 | payload.size());
+    } else {
+      rx.push_back(0x80 | 126);
+      rx.push_back(payload.size() >> 8);
+      rx.push_back(payload.size() & 0xff);
+    }
+    rx.insert(rx.end(), mask, mask + 4);
+    for(size_t i = 0; i < payload.size(); i++) {
+      rx.push_back(payload[i] ^ mask[i & 3]);
+    }
+    std::string& tx = socket->tx;
+    for(int n = 0; n < 4 && tx.size() < 2; n++) {
+      rad->update();
+    }
+    int code = 0;
+    if(tx.size() >= 2 && binary && tx.size() >= 6) {
+      code = ((uint8_t)tx[4] << 8) | (uint8_t)tx[5];
+    } else if(tx.size() >= 2 && !binary) {
+      size_t status = tx.find("\"status\":");
+      code = status != std::string::npos ? atoi(tx.c_str() + status + 9) : 0;
+    }
+    if(!expected(code)) {
+      _failures += 1;
+    }
+    tx.clear();
+  }
+#endif
+
+  bool expected(int code) {
+    return expect != 0 ? code == expect : code < 300;
+  }
+
+  std::string command(int i, const char* type, const char* data) {
+    std::string body = "{\"feature_id\": \"" + ids[i % ids.size()] + "\", \"command_type\": \"" + type + "\"";
+    if(data != NULL) {
+      body += std::string(", \"data\": ") + data;
+    }
+    return body + "}";
+  }
+};
+
+
+// JSON validation
+//
+// Only checks that a document is well formed, enough to catch truncated or
+// unescaped output without a full parser.
+
+struct Validator {
+  const char* p;
+  const char* end;
+
+  Validator(const std::string& doc) : p(doc.c_str()), end(doc.c_str() + doc.size()) {};
+
+  void space(void) {
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+  }
+
+  bool literal(const char* word) {
+    size_t len = strlen(word);
+    if((size_t)(end - p) < len || strncmp(p, word, len) != 0) return false;
+    p += len;
+    return true;
+  }
+
+  bool string(void) {
+    if(p >= end || *p++ != '"') return false;
+    while(p < end && *p != '"') {
+      if((uint8_t)*p < 0x20) return false;
+      if(*p++ == '\\') {
+        if(p >= end) return false;
+        if(*p == 'u') {
+          for(int i = 1; i <= 4; i++) {
+            if(p + i >= end || !isxdigit((uint8_t)p[i])) return false;
+          }
+          p += 4;
+        } else if(strchr("\"\\/bfnrt", *p) == NULL) {
+          return false;
+        }
+        p++;
+      }
+    }
+    return p++ < end;
+  }
+
+  bool number(void) {
+    const char* start = p;
+    if(p < end && *p == '-') p++;
+    while(p < end && (isdigit((uint8_t)*p) || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-')) p++;
+    return p > start;
+  }
+
+  bool value(void) {
+    space();
+    if(p >= end) return false;
+    if(*p == '{' || *p == '[') {
+      char close = *p++ == '{' ? '}' : ']';
+      space();
+      if(p < end && *p == close) {
+        p++;
+        return true;
+      }
+      for(;;) {
+        if(close == '}') {
+          space();
+          if(!string()) return false;
+          space();
+          if(p >= end || *p++ != ':') return false;
+        }
+        if(!value()) return false;
+        space();
+        if(p >= end) return false;
+        if(*p == close) {
+          p++;
+          return true;
+        }
+        if(*p++ != ',') return false;
+      }
+    }
+    if(*p == '"') return string();
+    return literal("true") || literal("false") || literal("null") || number();
+  }
+
+  bool valid(void) {
+    if(!value()) return false;
+    space();
+    return p == end;
+  }
+};
+
+
+// Gzip decoding
+//
+// RADDeflate only writes fixed Huffman blocks, so this inflater handles just
+// those and treats anything else as corrupt output.
+
+static const uint16_t LENGTH_BASE[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t LENGTH_EXTRA[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t DISTANCE_BASE[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t DISTANCE_EXTRA[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+
+struct Sink : public Print {
+  std::vector<uint8_t> data;
+
+  size_t write(uint8_t c) { data.push_back(c); return 1; };
+  size_t write(const uint8_t* buffer, size_t size) {
+    data.insert(data.end(), buffer, buffer + size);
+    return size;
+  };
+};
+
+
+struct Inflater {
+  const std::vector<uint8_t>& in;
+  size_t pos;
+  uint32_t bit;
+  bool error;
+
+  Inflater(const std::vector<uint8_t>& gz) : in(gz), pos(0), bit(0), error(false) {};
+
+  uint32_t bits(uint8_t count) {
+    uint32_t value = 0;
+    for(uint8_t i = 0; i < count; i++) {
+      if(pos >= in.size()) {
+        error = true;
+        return 0;
+      }
+      value |= ((in[pos] >> bit) & 1) << i;
+      if(++bit == 8) {
+        bit = 0;
+        pos++;
+      }
+    }
+    return value;
+  }
+
+  // Huffman codes are packed most significant bit first
+  uint16_t code(uint8_t count, uint16_t value = 0) {
+    for(uint8_t i = 0; i < count; i++) {
+      value = (value << 1) | bits(1);
+    }
+    return value;
+  }
+
+  uint16_t symbol(void) {
+    uint16_t value = code(7);
+    if(value < 0x18) {
+      return 256 + value;
+    }
+    value = code(1, value);
+    if(value >= 0x30 && value < 0xc0) {
+      return value - 0x30;
+    }
+    if(value >= 0xc0 && value < 0xc8) {
+      return 280 + value - 0xc0;
+    }
+    return 144 + code(1, value) - 0x190;
+  }
+
+  uint32_t word(void) {
+    uint32_t value = 0;
+    for(int i = 0; i < 4 && pos < in.size(); i++) {
+      value |= (uint32_t)in[pos++] << (i * 8);
+    }
+    return value;
+  }
+
+  // Decodes a gzip member into out and checks its CRC-32 and length trailer
+  bool gunzip(std::vector<uint8_t>& out) {
+    if(in.size() < 18 || in[0] != 0x1f || in[1] != 0x8b || in[2] != 8 || in[3] != 0) {
+      return false;
+    }
+    pos = 10;
+    bool final = false;
+    while(!final && !error) {
+      final = bits(1);
+      if(bits(2) != 1) {
+        return false;
+      }
+      for(;;) {
+        uint16_t sym = symbol();
+        if(error || sym > 285) {
+          return false;
+        }
+        if(sym < 256) {
+          out.push_back(sym);
+          continue;
+        }
+        if(sym == 256) {
+          break;
+        }
+        size_t length = LENGTH_BASE[sym - 257] + bits(LENGTH_EXTRA[sym - 257]);
+        uint16_t d = code(5);
+        if(d > 29) {
+          return false;
+        }
+        size_t distance = DISTANCE_BASE[d] + bits(DISTANCE_EXTRA[d]);
+        if(distance > out.size() || distance > RAD_DEFLATE_WINDOW) {
+          return false;
+        }
+        for(size_t i = 0; i < length; i++) {
+          out.push_back(out[out.size() - distance]);
+        }
+      }
+    }
+    if(bit > 0) {
+      bit = 0;
+      pos++;
+    }
+    if(error || pos + 8 != in.size()) {
+      return false;
+    }
+    uint32_t crc = word();
+    uint32_t size = word();
+    return crc == crc32(0, out.data(), out.size()) && size == (uint32_t)out.size();
+  }
+};
+
+
+// Scenarios
+
+static void scale(int features, int subscriptions) {
+  Fixture fx(features, subscriptions);
+
+  measure("command_get", features, subscriptions, [&](int i) {
+    fx.request(HTTP_POST, RAD_COMMANDS_PATH, fx.command(i * 7, "Get", NULL));
+  });
+  measure("command_set", features, subscriptions, [&](int i) {
+    fx.request(HTTP_POST, RAD_COMMANDS_PATH, fx.command(i * 7, "Set", i % 2 ? "true" : "false"));
+  });
+  measure("command_mixed", features, subscriptions, [&](int i) {
+    if(i % 5 == 0) {
+      fx.request(HTTP_POST, RAD_COMMANDS_PATH, fx.command(i * 7, "Set", i % 2 ? "true" : "false"));
+    } else {
+      fx.request(HTTP_POST, RAD_COMMANDS_PATH, fx.command(i * 7, "Get", NULL));
+    }
+  });
+  measure("state_get", features, subscriptions, [&](int i) {
+    (void)i;
+    fx.request(HTTP_GET, RAD_STATE_PATH, "");
+  });
+  measure("subscription_churn", features, subscriptions, [&](int i) {
+    // Renew an existing subscription, or add a new one every tenth request
+    int n = i % 10 == 0 || subscriptions == 0 ? subscriptions + i : (i * 13) % subscriptions;
+    std::string body = "{\"feature_id\": \"" + fx.ids[n % features] +
+                       "\", \"event_type\": \"State\", \"callback\": \"" + Fixture::callback(n) +
+                       "\", \"timeout\": 3600}";
+    fx.request(HTTP_POST, RAD_SUBSCRIPTIONS_PATH, body);
+  });
+#if RAD_ASYNC_SERVER
+  measure("command_get_pipelined", features, subscriptions, [&](int i) {
+    // Eight requests written back to back on the keep-alive connection
+    for(int n = 0; n < 8; n++) {
+      fx.write(HTTP_POST, RAD_COMMANDS_PATH, fx.command(i * 7 + n, "Get", NULL));
+    }
+    fx.read(8);
+  });
+#endif
+#if RAD_WEBSOCKET
+  measure("command_set_socket", features, subscriptions, [&](int i) {
+    uint8_t set[3] = {Set, (uint8_t)((i * 7) % features), (uint8_t)(i % 2)};
+    fx.frame(true, std::string((const char*)set, sizeof(set)));
+  });
+  measure("command_set_socket_json", features, subscriptions, [&](int i) {
+    fx.frame(false, fx.command(i * 7, "Set", i % 2 ? "true" : "false"));
+  });
+#endif
+  measure("update_idle", features, subscriptions, [&](int i) {
+    (void)i;
+    fx.rad->update();
+  });
+}
+
+
+static void fanout(int subscriptions) {
+  Fixture fx(1, subscriptions);
+  size_t delivered = _delivered;
+  auto op = [&](int i) {
+    fx.features[0]->send(State, i % 2 == 0);
+  };
+  measure("event_fanout", 1, subscriptions, op);
+  measure_stack(op);
+  if(subscriptions > 0 && (_delivered - delivered) < (size_t)subscriptions) {
+    fprintf(stderr, "warning: only %zu of %d subscribers notified\n", _delivered - delivered, subscriptions);
+  }
+}
+
+
+static void admission(void) {
+  Fixture fx(16, 0);
+  // Exhaust a single client bucket, every request after it is a 429
+  fx.rad->limit(1, 1, 0, 0);
+  fx.request(HTTP_POST, RAD_COMMANDS_PATH, fx.command(0, "Get", NULL));
+  fx.expect = 429;
+  measure("admission_reject", 16, 0, [&](int i) {
+    fx.request(HTTP_POST, RAD_COMMANDS_PATH, fx.command(i * 7, "Set", "true"));
+  });
+  fx.rad->limit(0, 0, 0, 0);
+}
+
+
+static void heap(void) {
+  // Every Set path, including a deferred feature, has to leave the number of
+  // live heap blocks where it found it once warmed up
+  Fixture fx(16, 0);
+  fx.features[0]->deferred();
+  auto op = [&](int i) {
+#if RAD_WEBSOCKET
+    if(i % 2 != 0) {
+      char frame[3] = {(char)Set, (char)(i % 16), (char)(i & 1)};
+      fx.frame(true, std::string(frame, sizeof(frame)));
+      return;
+    }
+#endif
+    fx.request(HTTP_POST, RAD_COMMANDS_PATH, fx.command(i, "Set", i % 4 < 2 ? "true" : "false"));
+  };
+  for(int i = 0; i < 64; i++) {
+    op(i);
+  }
+  size_t live = _live;
+  measure("command_set_heap", 16, 0, [&](int i) {
+    op(i);
+    if(_live > live) {
+      _failures += 1;
+      live = _live;
+    }
+  });
+}
+
+
+static void parse(void) {
+  const char* bodies[] = {
+    "{\"feature_id\": \"feature_12\", \"command_type\": \"Get\"}",
+    "{\"feature_id\": \"feature_12\", \"command_type\": \"Set\", \"data\": true}",
+    "{\"command_type\":\"Set\",\"data\":128,\"feature_id\":\"feature_12\"}"
+  };
+  String strings[] = {bodies[0], bodies[1], bodies[2]};
+  RADCommand command;
+
+  // Both paths end with the same RADCommand, the JSON path is what
+  // handleCommands used before the tokenizer and is still its fallback
+  measure("command_parse_fast", 1, 0, [&](int i) {
+    const String& body = strings[i % 3];
+    if(!parseCommand(body.c_str(), body.length(), &command) || !command.hasType) {
+      _failures += 1;
+    }
+  });
+  measure("command_parse_json", 1, 0, [&](int i) {
+    StaticJsonBuffer<255> jsonBuffer;
+    if(!parseCommandJson(jsonBuffer.parseObject(strings[i % 3]), &command) || !command.hasType) {
+      _failures += 1;
+    }
+  });
+}
+
+
+static void gzip(void) {
+  // Inputs covering literals from both code lengths, matches of every
+  // length up to 258, distances across the window and the literal only
+  // tail past 64 KB
+  std::vector<std::vector<uint8_t> > inputs(5);
+  std::string doc = "{\"swagger\":\"2.0\",\"paths\":{";
+  for(int i = 0; i < 64; i++) {
+    doc += "\"/features/feature_" + std::to_string(i) + "/commands\":{\"post\":{\"operationId\":\"execute_" +
+           std::to_string(i) + "\",\"responses\":{\"200\":{\"description\":\"Command result\"}}}},";
+  }
+  doc += "}}";
+  inputs[0].assign(doc.begin(), doc.end());
+  inputs[1].assign(1, 'x');
+  inputs[2].assign(1000, 'a');
+  uint32_t seed = 1;
+  for(int i = 0; i < 4096; i++) {
+    seed = seed * 1103515245 + 12345;
+    inputs[3].push_back(seed >> 16);
+  }
+  while(inputs[4].size() < 70000) {
+    inputs[4].insert(inputs[4].end(), doc.begin(), doc.end());
+  }
+  inputs.push_back(std::vector<uint8_t>());
+
+  measure("gzip_round_trip", 1, 0, [&](int i) {
+    const std::vector<uint8_t>& input = inputs[i % inputs.size()];
+    Sink sink;
+    std::vector<uint8_t> output;
+    size_t len = RADDeflate::gzip(input.data(), input.size(), sink);
+    Inflater inflater(sink.data);
+    if(len != sink.data.size() || !inflater.gunzip(output) || output != input) {
+      _failures += 1;
+    }
+  }, 500);
+}
+
+
+static void describe(void) {
+  // Long ids and names with characters that need escaping, each one used to
+  // overflow the fixed buffer entries were rendered into
+  Fixture fx(16, 0, "living_room_ceiling_dimmer_", "Living Room \"Ceiling\" Light Dimmer\\Main\tZone");
+  measure("api_describe", 16, 0, [&](int i) {
+    (void)i;
+    fx.request(HTTP_GET, RAD_API_PATH, "");
+    if(!Validator(fx.response).valid() || fx.response.find(fx.ids.back()) == std::string::npos) {
+      _failures += 1;
+    }
+  }, 200);
+}
+
+
+static void restore(int subscriptions) {
+  const int features = 16;
+  Fixture fx(features, subscriptions);
+  fx.rad->save();
+  // Each boot leaks its connector, keep the number of boots bounded
+  measure("boot_restore", features, subscriptions, [&](int i) {
+    (void)i;
+    RADConnector* rad = new RADConnector("bench");
+    for(int f = 0; f < features; f++) {
+      rad->add(new RADFeature(SwitchBinary, fx.ids[f].c_str()));
+    }
+    rad->begin();
+  }, 50);
+}
+
+
+static void write(FILE* out) {
+  fprintf(out, "{\n  \"suite\": \"rad-esp8266\",\n  \"server\": \"%s\",\n  \"ops\": %d,\n  \"results\": [\n",
+          RAD_ASYNC_SERVER ? "RADServer" : "ESP8266WebServer", _ops);
+  for(size_t i = 0; i < _results.size(); i++) {
+    Result& r = _results[i];
+    fprintf(out, "    {\"scenario\": \"%s\", \"features\": %d, \"subscriptions\": %d, \"ops\": %d, "
+                 "\"p50_us\": %.3f, \"p99_us\": %.3f, \"mean_us\": %.3f, \"ops_per_sec\": %.1f, "
+                 "\"allocs_per_op\": %.3f, \"failures\": %zu, \"stack_bytes\": %zu}%s\n",
+            r.scenario.c_str(), r.features, r.subscriptions, r.ops, r.p50, r.p99, r.mean,
+            r.throughput, r.allocations, r.failures, r.stack, i + 1 < _results.size() ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+
+int main(int argc, char** argv) {
+  const char* json = NULL;
+  bool quick = false;
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+      _ops = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      json = argv[++i];
+    } else if(strcmp(argv[i], "--quick") == 0) {
+      quick = true;
+    } else {
+      fprintf(stderr, "usage: %s [--ops N] [--quick] [--json FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+  if(_ops < 10) {
+    _ops = 10;
+  }
+
+  // Every callback host accepts every NOTIFY
+  HTTPClient::sink([](const String& url, const char* method, const uint8_t* body, size_t size) {
+    (void)url; (void)method; (void)body; (void)size;
+    _delivered += 1;
+    return HTTP_CODE_OK;
+  });
+
+  const int features[] = {1, 16, 64, 256};
+  const int subscriptions[] = {0, 64, 256, 1024};
+  for(int f = 0; f < 4; f++) {
+    for(int s = 0; s < 4; s++) {
+      if(quick && (f % 2 != 0 || s % 2 != 0)) continue;
+      scale(features[f], subscriptions[s]);
+    }
+  }
+  const int fanouts[] = {1, 16, 128, 1024};
+  for(int n = 0; n < 4; n++) {
+    if(quick && n % 2 != 0) continue;
+    fanout(fanouts[n]);
+  }
+
+  parse();
+  heap();
+  admission();
+  describe();
+  gzip();
+
+  const int restores[] = {0, 64, 256, 1024};
+  for(int n = 0; n < 4; n++) {
+    if(quick && n % 2 != 0) continue;
+    restore(restores[n]);
+  }
+
+  if(json != NULL) {
+    FILE* out = fopen(json, "w");
+    if(out == NULL) {
+      perror(json);
+      return 1;
+    }
+    write(out);
+    fclose(out);
+  } else {
+    write(stdout);
+  }
+  return 0;
+}
@@ -0,0 +1,82 @@
+// Minimal host stand-in for the ESP8266 Arduino core, just enough to build
+// src/RADESP8266 for the benchmark suite.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <functional>
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+
+#define PROGMEM
+#define PGM_P const char*
+#define FPSTR(p) (p)
+#define F(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+#define HIGH 0x1
+#define LOW  0x0
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void yield(void);
+
+class HardwareSerial : public Stream {
+
+  public:
+
+    size_t written;
+
+    HardwareSerial() : written(0) {};
+    void begin(unsigned long baud) { (void)baud; };
+    int available() { return 0; };
+    int read() { return -1; };
+    int peek() { return -1; };
+    int availableForWrite() { return 128; };
+    size_t write(uint8_t c) { (void)c; written += 1; return 1; };
+    size_t write(const uint8_t* buffer, size_t size) { (void)buffer; written += size; return size; };
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+
+  public:
+
+    uint32_t getChipId() { return 0x00a1b2c3; };
+    uint32_t getFreeHeap() { return 40000; };
+    void reset() {};
+    void restart() {};
+};
+
+extern EspClass ESP;
+
+class IPAddress {
+
+  private:
+
+    uint32_t _address;
+
+  public:
+
+    IPAddress() : _address(0) {};
+    IPAddress(uint32_t address) : _address(address) {};
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+      : _address(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {};
+    operator uint32_t() const { return _address; };
+    String toString() const {
+      char buff[16];
+      snprintf(buff, sizeof(buff), "%u.%u.%u.%u", _address & 0xff, (_address >> 8) & 0xff,
+               (_address >> 16) & 0xff, (_address >> 24) & 0xff);
+      return String(buff);
+    };
+};
@@ -0,0 +1,44 @@
+// Host stand-in for ESP8266HTTPClient. Outgoing requests are delivered to a
+// process wide sink function so the benchmark can play the part of the
+// callback hosts.
+
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+typedef std::function<int(const String& url, const char* method, const uint8_t* body, size_t size)> HTTPSinkFunction;
+
+class HTTPClient {
+
+  private:
+
+    String _url;
+    String _response;
+
+    static HTTPSinkFunction _sink;
+
+  public:
+
+    bool begin(String url) { _url = url; return true; };
+    void end() {};
+    void setTimeout(uint16_t timeout) { (void)timeout; };
+    void setReuse(bool reuse) { (void)reuse; };
+    void addHeader(const String& name, const String& value, bool first = false, bool replace = true) {
+      (void)name; (void)value; (void)first; (void)replace;
+    };
+    // Like the core, the String overload takes its copy and forwards the bytes
+    int sendRequest(const char* type, String payload) {
+      return sendRequest(type, (uint8_t*)payload.c_str(), payload.length());
+    };
+    int sendRequest(const char* type, uint8_t* payload, size_t size);
+    String getString() { return _response; };
+    static String errorToString(int error) { return String("error ") + String(error); };
+
+    // Benchmark interface
+    static void sink(HTTPSinkFunction func) { _sink = func; };
+};
@@ -0,0 +1,27 @@
+// Host stand-in for ESP8266SSDP, all calls are no-ops.
+
+#pragma once
+
+#include <Arduino.h>
+
+#define SSDP_UUID_SIZE 37
+
+class SSDPClass {
+
+  public:
+
+    bool begin() { return true; };
+    void setDeviceType(const char* s) { (void)s; };
+    void setName(const char* s) { (void)s; };
+    void setURL(const char* s) { (void)s; };
+    void setSchemaURL(const char* s) { (void)s; };
+    void setSerialNumber(const String& s) { (void)s; };
+    void setModelName(const char* s) { (void)s; };
+    void setModelNumber(const char* s) { (void)s; };
+    void setModelURL(const char* s) { (void)s; };
+    void setManufacturer(const char* s) { (void)s; };
+    void setManufacturerURL(const char* s) { (void)s; };
+    void setHTTPPort(uint16_t port) { (void)port; };
+};
+
+extern SSDPClass SSDP;
@@ -0,0 +1,98 @@
+// Host stand-in for ESP8266WebServer. Requests are injected directly by the
+// benchmark and dispatched to the registered handlers from handleClient(),
+// responses are captured for inspection instead of being written to a socket.
+
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <FS.h>
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+#define CONTENT_LENGTH_NOT_SET ((size_t) -2)
+
+struct WebRequest {
+  HTTPMethod method;
+  String uri;
+  String body;
+  std::vector<std::pair<String, String> > headers;
+  IPAddress remote;
+};
+
+struct WebResponse {
+  int code;
+  String contentType;
+  String body;
+  std::vector<std::pair<String, String> > headers;
+};
+
+class ESP8266WebServer {
+
+  public:
+
+    typedef std::function<void(void)> THandlerFunction;
+
+  private:
+
+    std::map<std::string, THandlerFunction> _handlers;
+    THandlerFunction _notFound;
+    std::vector<String> _collect;
+    std::deque<WebRequest> _queue;
+    WebRequest _request;
+    WebResponse _response;
+    std::vector<std::pair<String, String> > _pendingHeaders;
+    size_t _contentLength;
+    size_t _handled;
+    std::shared_ptr<WiFiPipe> _peer;
+
+    static ESP8266WebServer* _active;
+
+  public:
+
+    ESP8266WebServer(int port = 80) : _contentLength(CONTENT_LENGTH_NOT_SET), _handled(0),
+                                      _peer(std::make_shared<WiFiPipe>()) { (void)port; };
+
+    void begin() { _active = this; };
+    void handleClient();
+
+    void on(const String& uri, THandlerFunction handler) { _handlers[uri.c_str()] = handler; };
+    void on(const String& uri, HTTPMethod method, THandlerFunction handler) { (void)method; on(uri, handler); };
+    void onNotFound(THandlerFunction handler) { _notFound = handler; };
+    void collectHeaders(const char* headerKeys[], const size_t count);
+
+    String uri() { return _request.uri; };
+    HTTPMethod method() { return _request.method; };
+    WiFiClient client() { return WiFiClient(_peer); };
+    String arg(String name);
+    bool hasArg(String name) { return name == "plain" && _request.body.length() > 0; };
+    String header(String name);
+    bool hasHeader(String name);
+
+    void send(int code, const char* content_type = NULL, const String& content = String(""));
+    void send(int code, char* content_type, const String& content) { send(code, (const char*)content_type, content); };
+    void send(int code, const String& content_type, const String& content) { send(code, content_type.c_str(), content); };
+    void send_P(int code, PGM_P content_type, PGM_P content, size_t length) { send(code, content_type, String(std::string(content, length))); };
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(size_t length) { _contentLength = length; };
+    void sendContent(const String& content) { _response.body += content; };
+    template<typename T> size_t streamFile(T& file, const String& contentType) {
+      if(String(file.name()).endsWith(".gz")) {
+        sendHeader("Content-Encoding", "gzip");
+      }
+      String content = file.readString();
+      send(200, contentType, content);
+      return content.length();
+    };
+
+    // Benchmark interface
+    static ESP8266WebServer* active() { return _active; };
+    void inject(const WebRequest& request) { _queue.push_back(request); };
+    const WebResponse& response() { return _response; };
+    size_t handled() { return _handled; };
+};
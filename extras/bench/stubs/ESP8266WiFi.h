@@ -0,0 +1,94 @@
+// Host stand-in for ESP8266WiFi. Clients are in-memory byte pipes so the
+// benchmark can drive socket based code without a network stack.
+
+#pragma once
+
+#include <Arduino.h>
+#include <deque>
+#include <memory>
+
+struct WiFiPipe {
+  std::deque<uint8_t> rx;
+  std::string tx;
+  bool open;
+  IPAddress remote;
+  WiFiPipe() : open(true) {};
+};
+
+class WiFiClient : public Stream {
+
+  private:
+
+    std::shared_ptr<WiFiPipe> _pipe;
+
+  public:
+
+    WiFiClient() {};
+    WiFiClient(std::shared_ptr<WiFiPipe> pipe) : _pipe(pipe) {};
+
+    std::shared_ptr<WiFiPipe> pipe() { return _pipe; };
+
+    uint8_t connected() { return _pipe && (_pipe->open || !_pipe->rx.empty()); };
+    operator bool() { return connected(); };
+    int available() { return _pipe ? _pipe->rx.size() : 0; };
+    int read() {
+      if(!available()) return -1;
+      int c = _pipe->rx.front();
+      _pipe->rx.pop_front();
+      return c;
+    };
+    int read(uint8_t* buffer, size_t size) {
+      size_t n = 0;
+      while(n < size && available()) buffer[n++] = read();
+      return n;
+    };
+    int peek() { return available() ? _pipe->rx.front() : -1; };
+    size_t write(uint8_t c) { return write(&c, 1); };
+    size_t write(const uint8_t* buffer, size_t size) {
+      if(!_pipe || !_pipe->open) return 0;
+      _pipe->tx.append((const char*)buffer, size);
+      return size;
+    };
+    using Print::write;
+    size_t availableForWrite() { return 1460; };
+    void setNoDelay(bool nodelay) { (void)nodelay; };
+    void stop() { if(_pipe) _pipe->open = false; };
+    IPAddress remoteIP() { return _pipe ? _pipe->remote : IPAddress(); };
+};
+
+class WiFiServer {
+
+  private:
+
+    uint16_t _port;
+    std::shared_ptr<std::deque<WiFiClient> > _pending;
+
+  public:
+
+    WiFiServer(uint16_t port) : _port(port), _pending(std::make_shared<std::deque<WiFiClient> >()) {};
+    void begin();
+    void setNoDelay(bool nodelay) { (void)nodelay; };
+    uint16_t port() { return _port; };
+
+    // Queue a connection for the next call to available()
+    void accept(WiFiClient client) { _pending->push_back(client); };
+    static WiFiServer* listening(uint16_t port);
+
+    WiFiClient available(uint8_t* status = NULL) {
+      (void)status;
+      if(_pending->empty()) return WiFiClient();
+      WiFiClient client = _pending->front();
+      _pending->pop_front();
+      return client;
+    };
+};
+
+class WiFiClass {
+
+  public:
+
+    String macAddress() { return String("5C:CF:7F:A1:B2:C3"); };
+    IPAddress localIP() { return IPAddress(192, 168, 1, 100); };
+};
+
+extern WiFiClass WiFi;
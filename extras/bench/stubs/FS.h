@@ -0,0 +1,96 @@
+// Host stand-in for the SPIFFS file system, files live in memory.
+
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace fs {
+
+typedef std::map<std::string, std::shared_ptr<std::vector<uint8_t> > > FileMap;
+
+class File : public Stream {
+
+  private:
+
+    std::string _name;
+    std::shared_ptr<std::vector<uint8_t> > _data;
+    size_t _position;
+
+  public:
+
+    File() : _position(0) {};
+    File(const std::string& name, std::shared_ptr<std::vector<uint8_t> > data, size_t position)
+      : _name(name), _data(data), _position(position) {};
+
+    operator bool() const { return (bool)_data; };
+    const char* name() const { return _name.c_str(); };
+    size_t size() const { return _data ? _data->size() : 0; };
+    size_t position() const { return _position; };
+    bool seek(uint32_t position) { _position = position; return _position <= size(); };
+    void close() { _data.reset(); };
+
+    int available() { return _data && _position < _data->size() ? _data->size() - _position : 0; };
+    int read() { return available() ? (*_data)[_position++] : -1; };
+    int peek() { return available() ? (*_data)[_position] : -1; };
+    size_t read(uint8_t* buffer, size_t size) {
+      size_t n = 0;
+      while(n < size && available()) buffer[n++] = (*_data)[_position++];
+      return n;
+    };
+    size_t write(uint8_t c) { return write(&c, 1); };
+    size_t write(const uint8_t* buffer, size_t size) {
+      if(!_data) return 0;
+      if(_data->size() < _position + size) _data->resize(_position + size);
+      memcpy(&(*_data)[_position], buffer, size);
+      _position += size;
+      return size;
+    };
+    using Print::write;
+};
+
+class Dir {
+
+  private:
+
+    std::vector<std::string> _names;
+    size_t _index;
+
+  public:
+
+    Dir() : _index(0) {};
+    Dir(const std::vector<std::string>& names) : _names(names), _index(0) {};
+    bool next() { return ++_index <= _names.size(); };
+    String fileName() { return _index > 0 && _index <= _names.size() ? String(_names[_index - 1]) : String(); };
+};
+
+class FS {
+
+  private:
+
+    FileMap _files;
+
+  public:
+
+    bool begin() { return true; };
+    File open(const char* path, const char* mode);
+    File open(const String& path, const char* mode) { return open(path.c_str(), mode); };
+    bool exists(const char* path) { return _files.count(path) > 0; };
+    bool exists(const String& path) { return exists(path.c_str()); };
+    bool remove(const char* path) { return _files.erase(path) > 0; };
+    bool remove(const String& path) { return remove(path.c_str()); };
+    bool rename(const char* from, const char* to);
+    Dir openDir(const char* path);
+
+    // Benchmark interface
+    void format() { _files.clear(); };
+};
+
+}
+
+using fs::File;
+using fs::Dir;
+
+extern fs::FS SPIFFS;
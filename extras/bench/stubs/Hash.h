@@ -0,0 +1,7 @@
+// Host stand-in for the core's Hash library, only the raw SHA-1 is provided.
+
+#pragma once
+
+#include <Arduino.h>
+
+void sha1(const uint8_t* data, uint32_t size, uint8_t hash[20]);
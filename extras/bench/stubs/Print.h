@@ -0,0 +1,43 @@
+// Host stand-in for the Arduino Print class.
+
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "WString.h"
+
+class Print {
+
+  public:
+
+    virtual ~Print() {};
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+      size_t n = 0;
+      while(size--) n += write(*buffer++);
+      return n;
+    };
+    size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); };
+
+    size_t print(const char* s) { return write(s); };
+    size_t print(const String& s) { return write(s.c_str()); };
+    size_t print(char c) { return write((uint8_t)c); };
+    size_t print(int value) { return printf("%d", value); };
+    size_t print(unsigned int value) { return printf("%u", value); };
+    size_t print(long value) { return printf("%ld", value); };
+    size_t print(unsigned long value) { return printf("%lu", value); };
+    size_t println() { return write("\r\n"); };
+    template<typename T> size_t println(T value) { return print(value) + println(); };
+
+    size_t printf(const char* format, ...) __attribute__ ((format (printf, 2, 3))) {
+      char buff[256];
+      va_list args;
+      va_start(args, format);
+      int len = vsnprintf(buff, sizeof(buff), format, args);
+      va_end(args);
+      if(len < 0) return 0;
+      return write((const uint8_t*)buff, (size_t)len < sizeof(buff) ? len : sizeof(buff) - 1);
+    };
+};
@@ -0,0 +1,32 @@
+// Host stand-in for the Arduino Stream class.
+
+#pragma once
+
+#include "Print.h"
+
+class Stream : public Print {
+
+  public:
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {};
+
+    void setTimeout(unsigned long timeout) { (void)timeout; };
+
+    size_t readBytes(uint8_t* buffer, size_t length) {
+      size_t n = 0;
+      int c;
+      while(n < length && (c = read()) >= 0) buffer[n++] = (uint8_t)c;
+      return n;
+    };
+    size_t readBytes(char* buffer, size_t length) { return readBytes((uint8_t*)buffer, length); };
+
+    String readString() {
+      String s;
+      int c;
+      while((c = read()) >= 0) s += (char)c;
+      return s;
+    };
+};
@@ -0,0 +1,61 @@
+// Host stand-in for the Arduino String class, backed by std::string.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+class String {
+
+  private:
+
+    std::string _s;
+
+  public:
+
+    String(const char* s = "") : _s(s != NULL ? s : "") {};
+    String(const std::string& s) : _s(s) {};
+    String(char c) : _s(1, c) {};
+    explicit String(int value) : _s(std::to_string(value)) {};
+    explicit String(unsigned int value) : _s(std::to_string(value)) {};
+    explicit String(long value) : _s(std::to_string(value)) {};
+    explicit String(unsigned long value) : _s(std::to_string(value)) {};
+
+    const char* c_str() const { return _s.c_str(); };
+    unsigned int length() const { return _s.length(); };
+    bool reserve(unsigned int size) { _s.reserve(size); return true; };
+
+    bool concat(const String& s) { _s += s._s; return true; };
+    bool concat(const char* s) { _s += s; return true; };
+    bool concat(char c) { _s += c; return true; };
+    String& operator+=(const String& s) { _s += s._s; return *this; };
+    String& operator+=(const char* s) { _s += s; return *this; };
+    String& operator+=(char c) { _s += c; return *this; };
+
+    bool operator==(const String& s) const { return _s == s._s; };
+    bool operator==(const char* s) const { return _s == s; };
+    bool operator!=(const String& s) const { return _s != s._s; };
+    bool operator!=(const char* s) const { return _s != s; };
+    char operator[](unsigned int i) const { return i < _s.length() ? _s[i] : 0; };
+    char charAt(unsigned int i) const { return (*this)[i]; };
+
+    bool startsWith(const String& s) const { return _s.compare(0, s._s.length(), s._s) == 0; };
+    bool endsWith(const String& s) const {
+      return _s.length() >= s._s.length() &&
+             _s.compare(_s.length() - s._s.length(), s._s.length(), s._s) == 0;
+    };
+    int indexOf(char c, unsigned int from = 0) const {
+      size_t i = _s.find(c, from);
+      return i == std::string::npos ? -1 : (int)i;
+    };
+    String substring(unsigned int from) const { return from < _s.length() ? String(_s.substr(from)) : String(); };
+    String substring(unsigned int from, unsigned int to) const {
+      return from < _s.length() && to > from ? String(_s.substr(from, to - from)) : String();
+    };
+    long toInt() const { return atol(_s.c_str()); };
+};
+
+inline String operator+(const String& a, const String& b) { String s(a); s += b; return s; }
+inline String operator+(const String& a, const char* b) { String s(a); s += b; return s; }
@@ -0,0 +1,227 @@
+// Implementations for the host stand-ins.
+
+#include <Arduino.h>
+#include <ESP8266HTTPClient.h>
+#include <ESP8266SSDP.h>
+#include <ESP8266WebServer.h>
+#include <ESP8266WiFi.h>
+#include <FS.h>
+#include <Hash.h>
+#include <strings.h>
+#include <chrono>
+#include <map>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+SSDPClass SSDP;
+fs::FS SPIFFS;
+
+static const std::chrono::steady_clock::time_point _boot = std::chrono::steady_clock::now();
+
+
+unsigned long millis(void) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now() - _boot).count();
+}
+
+
+unsigned long micros(void) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - _boot).count();
+}
+
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+
+void yield(void) {
+}
+
+
+// WiFi
+
+static std::map<uint16_t, WiFiServer*> _listening;
+
+
+void WiFiServer::begin() {
+  _listening[_port] = this;
+}
+
+
+WiFiServer* WiFiServer::listening(uint16_t port) {
+  std::map<uint16_t, WiFiServer*>::iterator it = _listening.find(port);
+  return it != _listening.end() ? it->second : NULL;
+}
+
+
+// File system
+
+namespace fs {
+
+File FS::open(const char* path, const char* mode) {
+  FileMap::iterator it = _files.find(path);
+  if(mode[0] == 'r') {
+    if(it == _files.end()) return File();
+    return File(path, it->second, 0);
+  }
+  if(mode[0] == 'w' || it == _files.end()) {
+    _files[path] = std::make_shared<std::vector<uint8_t> >();
+  }
+  std::shared_ptr<std::vector<uint8_t> > data = _files[path];
+  return File(path, data, mode[0] == 'a' ? data->size() : 0);
+}
+
+
+bool FS::rename(const char* from, const char* to) {
+  FileMap::iterator it = _files.find(from);
+  if(it == _files.end()) return false;
+  _files[to] = it->second;
+  _files.erase(from);
+  return true;
+}
+
+
+Dir FS::openDir(const char* path) {
+  std::vector<std::string> names;
+  for(FileMap::iterator it = _files.begin(); it != _files.end(); ++it) {
+    if(it->first.compare(0, strlen(path), path) == 0) names.push_back(it->first);
+  }
+  return Dir(names);
+}
+
+}
+
+
+// Web server
+
+ESP8266WebServer* ESP8266WebServer::_active = NULL;
+
+
+void ESP8266WebServer::handleClient() {
+  if(_queue.empty()) {
+    return;
+  }
+  _request = _queue.front();
+  _queue.pop_front();
+  _response = WebResponse();
+  _pendingHeaders.clear();
+  _contentLength = CONTENT_LENGTH_NOT_SET;
+  _peer->remote = _request.remote;
+  _handled += 1;
+  std::map<std::string, THandlerFunction>::iterator it = _handlers.find(_request.uri.c_str());
+  if(it != _handlers.end()) {
+    it->second();
+  } else if(_notFound) {
+    _notFound();
+  } else {
+    send(404, "text/plain", "Not found");
+  }
+}
+
+
+void ESP8266WebServer::collectHeaders(const char* headerKeys[], const size_t count) {
+  _collect.clear();
+  for(size_t i = 0; i < count; i++) {
+    _collect.push_back(headerKeys[i]);
+  }
+}
+
+
+String ESP8266WebServer::arg(String name) {
+  if(name == "plain") {
+    return _request.body;
+  }
+  return String();
+}
+
+
+String ESP8266WebServer::header(String name) {
+  for(size_t i = 0; i < _request.headers.size(); i++) {
+    if(strcasecmp(_request.headers[i].first.c_str(), name.c_str()) == 0) {
+      return _request.headers[i].second;
+    }
+  }
+  return String();
+}
+
+
+bool ESP8266WebServer::hasHeader(String name) {
+  for(size_t i = 0; i < _request.headers.size(); i++) {
+    if(strcasecmp(_request.headers[i].first.c_str(), name.c_str()) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+void ESP8266WebServer::send(int code, const char* content_type, const String& content) {
+  _response.code = code;
+  _response.contentType = content_type != NULL ? content_type : "";
+  _response.headers = _pendingHeaders;
+  _response.body = content;
+  _pendingHeaders.clear();
+}
+
+
+void ESP8266WebServer::sendHeader(const String& name, const String& value, bool first) {
+  if(first) {
+    _pendingHeaders.insert(_pendingHeaders.begin(), std::make_pair(name, value));
+  } else {
+    _pendingHeaders.push_back(std::make_pair(name, value));
+  }
+}
+
+
+// HTTP client
+
+HTTPSinkFunction HTTPClient::_sink;
+
+
+int HTTPClient::sendRequest(const char* type, uint8_t* payload, size_t size) {
+  if(!_sink) {
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+  return _sink(_url, type, payload, size);
+}
+
+
+// Hash
+
+static uint32_t rol(uint32_t value, int bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+
+void sha1(const uint8_t* data, uint32_t size, uint8_t hash[20]) {
+  uint32_t h[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+  std::vector<uint8_t> message(data, data + size);
+  message.push_back(0x80);
+  while(message.size() % 64 != 56) message.push_back(0);
+  uint64_t bits = (uint64_t)size * 8;
+  for(int i = 7; i >= 0; i--) message.push_back(bits >> (i * 8));
+  for(size_t chunk = 0; chunk < message.size(); chunk += 64) {
+    uint32_t w[80];
+    for(int i = 0; i < 16; i++) {
+      w[i] = (uint32_t)message[chunk + i * 4] << 24 | (uint32_t)message[chunk + i * 4 + 1] << 16 |
+             (uint32_t)message[chunk + i * 4 + 2] << 8 | message[chunk + i * 4 + 3];
+    }
+    for(int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for(int i = 0; i < 80; i++) {
+      uint32_t f, k;
+      if(i < 20) { f = (b & c) | (~b & d); k = 0x5a827999; }
+      else if(i < 40) { f = b ^ c ^ d; k = 0x6ed9eba1; }
+      else if(i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8f1bbcdc; }
+      else { f = b ^ c ^ d; k = 0xca62c1d6; }
+      uint32_t t = rol(a, 5) + f + e + k + w[i];
+      e = d; d = c; c = rol(b, 30); b = a; a = t;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+  }
+  for(int i = 0; i < 20; i++) hash[i] = h[i / 4] >> (24 - (i % 4) * 8);
+}
@@ -4,8 +4,81 @@
 #define MAX_CALLBACK_SIZE 255
 #define RAD_MIN_TIMEOUT 90
 #define RAD_MIN_WRITE_INTERVAL 60
+#define RAD_MAX_SUBSCRIPTION_ERRORS 10
+
+#define RAD_NOTIFY_TIMEOUT 2000
+#define RAD_MAX_CALLBACK_HOSTS 8
+#define RAD_CIRCUIT_THRESHOLD 3
+#define RAD_CIRCUIT_BACKOFF 5
+#define RAD_CIRCUIT_MAX_BACKOFF 300
+
+// Shared buffer event bodies are rendered into, custom bodies passed to
+// sendEvent() that don't fit are copied to the heap up to the larger limit
+#define RAD_EVENT_SIZE 128
+#define RAD_CUSTOM_EVENT_SIZE 1024
+
+#define RAD_SAMPLE_INTERVAL 100
+
+#define RAD_DEFERRED_COMMANDS 8
+
+// DNS-SD advertisement of _rad._tcp with a feature summary in TXT records
+#ifndef RAD_MDNS
+#define RAD_MDNS 0
+#endif
+#define RAD_MDNS_SERVICE "rad"
+#define RAD_MDNS_TXT_SIZE 255
+
+// API description, generated in begin() and kept gzip compressed in SPIFFS
+#define RAD_API_FILE_PREFIX "/rad-api-"
+#define RAD_API_MAX_AGE 86400
+#define RAD_DEFLATE_WINDOW 32768
+#define RAD_DEFLATE_HASH_BITS 10
+#define RAD_DEFLATE_BUFFER 64
+
+// Log ring, RAD_LOG_LEVEL selects what is compiled in
+#define RAD_LOG_SIZE 32
+#define RAD_LOG_LINE 96
+#define RAD_LOG_DRAIN 2
+#ifndef RAD_LOG_SERIAL
+#define RAD_LOG_SERIAL 1
+#endif
+
+// Admission control, rates are requests per second and 0 disables a bucket
+#define RAD_LIMIT_CLIENTS 8
+#define RAD_LIMIT_CLIENT_RATE 10
+#define RAD_LIMIT_CLIENT_BURST 20
+#define RAD_LIMIT_GLOBAL_RATE 40
+#define RAD_LIMIT_GLOBAL_BURST 80
+
+#define RAD_HISTORY_RAW_SIZE 60
+#define RAD_HISTORY_RAW_PERIOD 1
+#define RAD_HISTORY_BUCKET_SIZE 60
+#define RAD_HISTORY_BUCKET_PERIOD 60
 
 #define RAD_HTTP_PORT 80
+
+// Set to 1 to serve the API with RADServer, which keeps several HTTP/1.1
+// connections open at once, instead of ESP8266WebServer
+#ifndef RAD_ASYNC_SERVER
+#define RAD_ASYNC_SERVER 0
+#endif
+#define RAD_SERVER_MAX_CLIENTS 4
+#define RAD_SERVER_MAX_LINE 256
+#define RAD_SERVER_MAX_BODY 1024
+#define RAD_SERVER_MAX_HEADERS 8
+#define RAD_SERVER_IDLE_TIMEOUT 5000
+
+// Set to 1 to accept commands over a WebSocket, see RADSocket. Clients are
+// expected to ping before the idle timeout to keep a quiet socket open
+#ifndef RAD_WEBSOCKET
+#define RAD_WEBSOCKET 0
+#endif
+#define RAD_WEBSOCKET_PORT 81
+#define RAD_WEBSOCKET_MAX_CLIENTS 2
+#define RAD_WEBSOCKET_MAX_FRAME 256
+#define RAD_WEBSOCKET_MAX_FEATURES 64
+#define RAD_WEBSOCKET_IDLE_TIMEOUT 120000
+
 #define RAD_DEVICE_TYPE "urn:rad:device:esp8266:1"
 #define RAD_MODEL_NAME "RAD-ESP8266"
 #define RAD_MODEL_NUM "9001"
@@ -16,10 +89,25 @@
 #define RAD_SUBSCRIPTIONS_PATH "/subscriptions"
 #define RAD_COMMANDS_PATH "/commands"
 #define RAD_EVENTS_PATH "/events"
+#define RAD_HISTORY_PATH "/history"
+#define RAD_STATS_PATH "/stats"
+#define RAD_STATE_PATH "/state"
+#define RAD_LOG_PATH "/log"
+#define RAD_API_PATH "/api.json"
+// Seeds the /features ETag and DNS-SD hash, bump it whenever the documents
+// built from the features change format so cached copies are refetched
+#define RAD_DOCUMENT_VERSION 2
 
-#define RAD_SUBSCRIPTIONS_FILE "/rad-subscriptions.json"
+#define RAD_SUBSCRIPTIONS_FILE "/rad-subscriptions.bin"
+#define RAD_SUBSCRIPTIONS_TEMP_FILE "/rad-subscriptions.tmp"
+#define RAD_SNAPSHOT_MAGIC 0x53444152
+#define RAD_SNAPSHOT_VERSION 2
 
 #define HEADER_HOST      "HOST"
 #define HEADER_CALLBACK  "CALLBACK"
 #define HEADER_NT        "NT"
-#define HEADER_TIMEOUT   "TIMEOUT"
\ No newline at end of file
+#define HEADER_TIMEOUT   "TIMEOUT"
+#define HEADER_IF_NONE_MATCH "If-None-Match"
+#define HEADER_ETAG      "ETag"
+#define HEADER_CACHE_CONTROL "Cache-Control"
+#define HEADER_ACCEPT_ENCODING "Accept-Encoding"
\ No newline at end of file
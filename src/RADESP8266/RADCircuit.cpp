@@ -0,0 +1,126 @@
+#include "RADCircuit.h"
+
+
+RADCircuit RADCircuit::_circuits[RAD_MAX_CALLBACK_HOSTS];
+
+
+RADCircuit::RADCircuit() {
+  _host[0] = '\0';
+  _state = CircuitClosed;
+  _failures = 0;
+  _retry = 0;
+  _used = 0;
+}
+
+
+bool RADCircuit::allow(long current) {
+  bool result = false;
+  _used = current;
+  switch(_state) {
+    case CircuitClosed:
+      result = true;
+      break;
+    case CircuitOpen:
+      // Let a single probe through once the backoff has expired
+      if(current - _retry >= 0) {
+        _state = CircuitHalfOpen;
+        result = true;
+      }
+      break;
+    case CircuitHalfOpen:
+      // A probe is already in flight
+      result = false;
+      break;
+  }
+  return result;
+}
+
+
+void RADCircuit::success(long current) {
+  _used = current;
+  _state = CircuitClosed;
+  _failures = 0;
+}
+
+
+void RADCircuit::failure(long current) {
+  _used = current;
+  if(_failures < 255) {
+    _failures += 1;
+  }
+  if(_state == CircuitHalfOpen || _failures >= RAD_CIRCUIT_THRESHOLD) {
+    // Double the backoff for every failure past the threshold
+    long backoff = RAD_CIRCUIT_BACKOFF;
+    for(int i = RAD_CIRCUIT_THRESHOLD; i < _failures && backoff < RAD_CIRCUIT_MAX_BACKOFF; i++) {
+      backoff *= 2;
+    }
+    if(backoff > RAD_CIRCUIT_MAX_BACKOFF) {
+      backoff = RAD_CIRCUIT_MAX_BACKOFF;
+    }
+    _state = CircuitOpen;
+    _retry = current + backoff * 1000;
+  }
+}
+
+
+RADCircuit* RADCircuit::get(const char* callback, long current) {
+  char host[CIRCUIT_HOST_SIZE];
+  RADCircuit* circuit = NULL;
+  RADCircuit* candidate = NULL;
+  if(!parseHost(callback, host, sizeof(host))) {
+    return NULL;
+  }
+  for(int i = 0; i < RAD_MAX_CALLBACK_HOSTS; i++) {
+    circuit = &_circuits[i];
+    if(strcmp(circuit->_host, host) == 0) {
+      return circuit;
+    }
+    // Open and probing circuits keep their slot, evicting them would throw
+    // away the backoff of a host that is known to be down
+    if(circuit->_host[0] != '\0' && circuit->_state != CircuitClosed) {
+      continue;
+    }
+    if(candidate == NULL || evicts(circuit, candidate)) {
+      candidate = circuit;
+    }
+  }
+  if(candidate == NULL) {
+    // Every slot holds a failing host, this one is sent to without a circuit
+    return NULL;
+  }
+  *candidate = RADCircuit();
+  strncpy(candidate->_host, host, sizeof(candidate->_host));
+  candidate->_used = current;
+  return candidate;
+}
+
+
+bool RADCircuit::evicts(RADCircuit* a, RADCircuit* b) {
+  // Prefer empty slots, then the least recently used
+  if(b->_host[0] == '\0') {
+    return false;
+  } else if(a->_host[0] == '\0') {
+    return true;
+  }
+  return a->_used - b->_used < 0;
+}
+
+
+bool RADCircuit::parseHost(const char* callback, char* host, size_t len) {
+  const char* start = strstr(callback, "://");
+  if(start == NULL) {
+    start = callback;
+  } else {
+    start += 3;
+  }
+  size_t i = 0;
+  while(start[i] != '\0' && start[i] != '/' && start[i] != '?') {
+    if(i + 1 >= len) {
+      return false;
+    }
+    host[i] = start[i];
+    i++;
+  }
+  host[i] = '\0';
+  return i > 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Defines.h"
+#include "Types.h"
+
+#define CIRCUIT_HOST_SIZE 64
+
+// Circuit States
+enum CircuitState {
+    CircuitClosed   = 0,
+    CircuitOpen     = 1,
+    CircuitHalfOpen = 2
+};
+
+// Tracks the health of a single callback host. Once a host has failed
+// RAD_CIRCUIT_THRESHOLD times in a row the circuit opens and NOTIFY requests
+// to it are skipped until the backoff expires, at which point a single probe
+// request is let through to decide whether the circuit closes again.
+class RADCircuit {
+
+  private:
+
+    char _host[CIRCUIT_HOST_SIZE];
+    CircuitState _state;
+    uint8_t _failures;
+    long _retry;
+    long _used;
+
+    static RADCircuit _circuits[RAD_MAX_CALLBACK_HOSTS];
+    static bool evicts(RADCircuit* a, RADCircuit* b);
+
+  public:
+
+    RADCircuit();
+
+    const char* getHost() { return _host; };
+    CircuitState getState() { return _state; };
+    uint8_t getFailures() { return _failures; };
+
+    bool allow(long current);
+    void success(long current);
+    void failure(long current);
+
+    static RADCircuit* get(const char* callback, long current);
+    static bool parseHost(const char* callback, char* host, size_t len);
+};
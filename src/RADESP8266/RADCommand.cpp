@@ -0,0 +1,200 @@
+
+#include "RADCommand.h"
+
+
+static const char* skipSpace(const char* p, const char* end) {
+  while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+    p++;
+  }
+  return p;
+}
+
+
+static const char* scanString(const char* p, const char* end, const char** s, size_t* len) {
+  if(p == end || *p != '"') {
+    return NULL;
+  }
+  const char* start = ++p;
+  while(p < end && *p != '"') {
+    if(*p == '\\' || (uint8_t)*p < 0x20) {
+      return NULL;
+    }
+    p++;
+  }
+  if(p == end) {
+    return NULL;
+  }
+  *s = start;
+  *len = p - start;
+  return p + 1;
+}
+
+
+static bool matches(const char* s, size_t len, const char* literal) {
+  return strlen(literal) == len && memcmp(s, literal, len) == 0;
+}
+
+
+static const char* scanData(const char* p, const char* end, RADCommand* command) {
+  const char* s;
+  size_t len;
+  if(end - p >= 4 && memcmp(p, "true", 4) == 0) {
+    command->dataType = BoolPayload;
+    command->data = 255;
+    p += 4;
+  } else if(end - p >= 5 && memcmp(p, "false", 5) == 0) {
+    command->dataType = BoolPayload;
+    command->data = 0;
+    p += 5;
+  } else if(*p >= '0' && *p <= '9') {
+    unsigned int value = 0;
+    const char* start = p;
+    while(p < end && *p >= '0' && *p <= '9' && p - start < 4) {
+      value = value * 10 + (*p - '0');
+      p++;
+    }
+    // Leave leading zeros, fractions, exponents and larger values to ArduinoJson
+    if(value > 255 || (*start == '0' && p - start > 1) ||
+       (p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E'))) {
+      return NULL;
+    }
+    command->dataType = BytePayload;
+    command->data = value;
+  } else if(*p == '"') {
+    // Strings are only typed, no feature takes byte arrays so dispatch()
+    // rejects them without needing the decoded data
+    p = scanString(p, end, &s, &len);
+    command->dataType = ByteArrayPayload;
+    command->data = 0;
+  } else {
+    return NULL;
+  }
+  if(p != NULL) {
+    command->hasData = true;
+  }
+  return p;
+}
+
+
+const char* sendCommandState(CommandState cs) {
+  const char* s = "Free";
+  if(cs == CommandQueued) {
+    s = "Queued";
+  } else if(cs == CommandComplete) {
+    s = "Complete";
+  } else if(cs == CommandFailed) {
+    s = "Failed";
+  }
+  return s;
+}
+
+
+static void clear(RADCommand* command) {
+  command->hasFeatureId = false;
+  command->featureId = NULL;
+  command->featureIdLen = 0;
+  command->hasType = false;
+  command->type = NullCommand;
+  command->hasData = false;
+  command->dataType = NullPayload;
+  command->data = 0;
+}
+
+
+bool parseCommand(const char* json, size_t len, RADCommand* command) {
+  const char* p = json;
+  const char* end = json + len;
+  const char* key;
+  size_t keyLen;
+  const char* value;
+  size_t valueLen;
+  clear(command);
+  p = skipSpace(p, end);
+  if(p == end || *p != '{') {
+    return false;
+  }
+  p = skipSpace(p + 1, end);
+  if(p < end && *p == '}') {
+    return skipSpace(p + 1, end) == end;
+  }
+  while(true) {
+    p = scanString(p, end, &key, &keyLen);
+    if(p == NULL) {
+      return false;
+    }
+    p = skipSpace(p, end);
+    if(p == end || *p != ':') {
+      return false;
+    }
+    p = skipSpace(p + 1, end);
+    if(p == end) {
+      return false;
+    }
+    if(matches(key, keyLen, "feature_id") && !command->hasFeatureId) {
+      p = scanString(p, end, &command->featureId, &command->featureIdLen);
+      command->hasFeatureId = true;
+    } else if(matches(key, keyLen, "command_type") && !command->hasType) {
+      p = scanString(p, end, &value, &valueLen);
+      if(p != NULL) {
+        command->type = getCommandType(value, valueLen);
+      }
+      command->hasType = true;
+    } else if(matches(key, keyLen, "data") && !command->hasData) {
+      p = scanData(p, end, command);
+    } else {
+      return false;
+    }
+    if(p == NULL) {
+      return false;
+    }
+    p = skipSpace(p, end);
+    if(p == end) {
+      return false;
+    } else if(*p == '}') {
+      return skipSpace(p + 1, end) == end;
+    } else if(*p != ',') {
+      return false;
+    }
+    p = skipSpace(p + 1, end);
+  }
+}
+
+
+bool parseCommandJson(JsonObject& root, RADCommand* command) {
+  clear(command);
+  if(!root.success()) {
+    return false;
+  }
+  if(root.containsKey("feature_id")) {
+    command->hasFeatureId = true;
+    command->featureId = root["feature_id"];
+    if(command->featureId != NULL) {
+      command->featureIdLen = strlen(command->featureId);
+    }
+  }
+  if(root.containsKey("command_type")) {
+    const char* type = root["command_type"];
+    command->hasType = true;
+    if(type != NULL) {
+      command->type = getCommandType(type);
+    }
+  }
+  if(root.containsKey("data")) {
+    command->hasData = true;
+    if(root["data"].is<bool>()) {
+      command->dataType = BoolPayload;
+      command->data = root["data"].as<bool>() ? 255 : 0;
+    } else if(root["data"].is<int>()) {
+      // Same range as the fast path, anything else is not a byte
+      int value = root["data"].as<int>();
+      if(value < 0 || value > 255) {
+        return false;
+      }
+      command->dataType = BytePayload;
+      command->data = value;
+    } else if(root["data"].is<char*>()) {
+      command->dataType = ByteArrayPayload;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include "Types.h"
+
+// A command request body, {"feature_id": ..., "command_type": ..., "data": ...}.
+// Strings point into the request body rather than being copied, so on the fast
+// path featureId is not NUL terminated and featureIdLen must be used.
+struct RADCommand {
+  bool hasFeatureId;
+  const char* featureId;
+  size_t featureIdLen;
+  bool hasType;
+  CommandType type;
+  bool hasData;
+  PayloadType dataType;
+  uint8_t data;
+};
+
+// Deferred Command States
+enum CommandState {
+    CommandFree     = 0,
+    CommandQueued   = 1,
+    CommandComplete = 2,
+    CommandFailed   = 3
+};
+
+class RADFeature;
+
+// A bool or byte Set on a deferred feature, accepted with 202 and run later
+// from RADConnector::update(). Finished slots are kept for the status resource
+// until they are reused by newer commands.
+struct RADDeferredCommand {
+  uint16_t id;
+  CommandState state;
+  RADFeature* feature;
+  CommandType type;
+  PayloadType dataType;
+  uint8_t data;
+};
+
+const char* sendCommandState(CommandState cs);
+
+// Tokenizes the fixed command schema straight out of the request body without
+// allocating. Returns false for anything outside of it (escaped strings, nested
+// values, unknown or repeated keys, numbers other than 0-255) so the caller can
+// fall back to parseCommandJson().
+bool parseCommand(const char* json, size_t len, RADCommand* command);
+
+// General path for any other JSON body, returns false when it isn't valid JSON
+// or data is a number outside 0-255 so both parsers refuse the same input
+bool parseCommandJson(JsonObject& root, RADCommand* command);
@@ -1,11 +1,20 @@
 
 #include "RADConnector.h"
 
-RADConnector::RADConnector(const char* name) {
+RADConnector::RADConnector(const char* name) : _http(RAD_HTTP_PORT) {
   _name = name;
-  _http = ESP8266WebServer(RAD_HTTP_PORT);
   _subscriptionCount = 0;
   _lastWrite = 0;
+  _subscriptionsChanged = false;
+  _startupTime = 0;
+  _deferredId = 0;
+  _idle = true;
+  _featuresHash = 0;
+  _apiHash = 0;
+  _apiFile[0] = '\0';
+  for(int i = 0; i < RAD_DEFERRED_COMMANDS; i++) {
+    _deferred[i].state = CommandFree;
+  }
 }
 
 
@@ -13,17 +22,86 @@ static const char* HEADERS[] = {
   HEADER_HOST,
   HEADER_CALLBACK,
   HEADER_NT,
-  HEADER_TIMEOUT
+  HEADER_TIMEOUT,
+  HEADER_IF_NONE_MATCH,
+  HEADER_ACCEPT_ENCODING
 };
 
 
+// Routes that are the same on every device, see describe()
+static const char API_PATHS[] =
+  "\"/\":{\"get\":{\"operationId\":\"info\",\"responses\":{\"200\":{\"description\":\"Device info\"}}}},"
+  "\"" RAD_FEATURES_PATH "\":{\"get\":{\"operationId\":\"listFeatures\",\"responses\":{"
+    "\"200\":{\"description\":\"Registered features\"},\"304\":{\"description\":\"Not modified\"}}}},"
+  "\"" RAD_COMMANDS_PATH "\":{\"post\":{\"operationId\":\"execute\",\"parameters\":[{\"name\":\"command\","
+    "\"in\":\"body\",\"required\":true,\"schema\":{\"$ref\":\"#/definitions/Command\"}}],\"responses\":{"
+    "\"200\":{\"description\":\"Command result\"},\"202\":{\"description\":\"Command queued\"},"
+    "\"400\":{\"description\":\"Invalid command\",\"schema\":{\"$ref\":\"#/definitions/Error\"}},"
+    "\"503\":{\"description\":\"Command queue full\"}}}},"
+  "\"" RAD_COMMANDS_PATH "/{command_id}\":{\"get\":{\"operationId\":\"commandStatus\",\"parameters\":[{"
+    "\"name\":\"command_id\",\"in\":\"path\",\"required\":true,\"type\":\"integer\"}],\"responses\":{"
+    "\"200\":{\"description\":\"Command state\"},\"404\":{\"description\":\"Unknown command\"}}}},"
+  "\"" RAD_SUBSCRIPTIONS_PATH "\":{\"get\":{\"operationId\":\"listSubscriptions\",\"responses\":{"
+    "\"200\":{\"description\":\"Active subscriptions\"}}},\"post\":{\"operationId\":\"subscribe\","
+    "\"parameters\":[{\"name\":\"subscription\",\"in\":\"body\",\"required\":true,"
+    "\"schema\":{\"$ref\":\"#/definitions/Subscription\"}}],\"responses\":{"
+    "\"200\":{\"description\":\"Subscription created\"}}}},"
+  "\"" RAD_STATE_PATH "\":{\"get\":{\"operationId\":\"state\",\"responses\":{"
+    "\"200\":{\"description\":\"Value of every feature\"},\"304\":{\"description\":\"Not modified\"}}}},"
+  "\"" RAD_STATS_PATH "\":{\"get\":{\"operationId\":\"stats\",\"responses\":{"
+    "\"200\":{\"description\":\"Admission counters\"}}}},"
+  "\"" RAD_LOG_PATH "\":{\"get\":{\"operationId\":\"log\",\"produces\":[\"text/plain\"],\"responses\":{"
+    "\"200\":{\"description\":\"Recent log records\"}}}},"
+  "\"" RAD_API_PATH "\":{\"get\":{\"operationId\":\"api\",\"responses\":{"
+    "\"200\":{\"description\":\"This document\"},\"304\":{\"description\":\"Not modified\"}}}}";
+
+static const char API_DEFINITIONS[] =
+  "\"Subscription\":{\"type\":\"object\",\"required\":[\"event_type\",\"callback\"],\"properties\":{"
+    "\"feature_id\":{\"$ref\":\"#/definitions/FeatureId\"},"
+    "\"event_type\":{\"type\":\"string\",\"enum\":[\"All\",\"Start\",\"State\",\"Complete\"]},"
+    "\"callback\":{\"type\":\"string\"},\"timeout\":{\"type\":\"integer\"},"
+    "\"filter\":{\"type\":\"string\",\"enum\":[\"Equals\",\"Crosses\",\"Changed\"]},"
+    "\"value\":{},\"interval\":{\"type\":\"integer\"}}},"
+  "\"Error\":{\"type\":\"object\",\"properties\":{\"error\":{\"type\":\"string\"}}}";
+
+
+
+void RADConnector::on(const char* uri, std::function<void(void)> handler) {
+  // Every route is admitted before its handler runs
+  _http.on(uri, [this, handler]() {
+    if(admit()) {
+      handler();
+    }
+  });
+}
+
+
+bool RADConnector::admit(void) {
+  int retry = 0;
+  _idle = false;
+  if(RADLimiter::admit((uint32_t)_http.client().remoteIP(), millis(), &retry)) {
+    return true;
+  }
+  _http.sendHeader("Retry-After", String(retry));
+  _http.send(429, "application/json", "{\"error\": \"Too many requests.\"}");
+  return false;
+}
+
+
+void RADConnector::limit(uint16_t client_rate, uint16_t client_burst,
+                         uint16_t global_rate, uint16_t global_burst) {
+  RADLimiter::configure(client_rate, client_burst, global_rate, global_burst);
+}
+
+
 void RADConnector::add(RADFeature* feature) {
   _features.add(feature);
 }
 
 
 RADSubscription* RADConnector::subscribe(RADFeature* feature, EventType type,
-                                    const char* callback, int timeout) {
+                                    const char* callback, int timeout,
+                                    FilterType filter, uint8_t threshold, int interval) {
   RADSubscription* s;
   RADFeature* f;
   for(int i = 0; i < _subscriptions.size(); i++) {
@@ -44,6 +122,7 @@ RADSubscription* RADConnector::subscribe(RADFeature* feature, EventType type,
   (uint16_t)   chipId        & 0xff ,
               _subscriptionCount);
   s = new RADSubscription(feature, sid, type, callback, timeout);
+  s->filter(filter, threshold, interval);
   _subscriptions.add(s);
   feature->add(s);
   _subscriptionsChanged = true;
@@ -68,52 +147,7 @@ bool RADConnector::begin(void) {
   SPIFFS.begin();
 
   // Load the existing subscriptions from SPIFFS
-  if(SPIFFS.exists(RAD_SUBSCRIPTIONS_FILE)) {
-    File f = SPIFFS.open(RAD_SUBSCRIPTIONS_FILE, "r");
-    // Check if file opened sucessfully
-    if(f) {
-      String subcription_data = f.readString();
-      f.close();
-      StaticJsonBuffer<2048> jsonBuffer;
-      JsonObject& subscription_json = jsonBuffer.parseObject(subcription_data);
-      if(subscription_json.containsKey("count")) {
-        _subscriptionCount = subscription_json["count"];
-      }
-      if(subscription_json.containsKey("subscriptions")) {
-        JsonArray& subscription_array = subscription_json["subscriptions"];
-        RADFeature* feature;
-        RADSubscription* s;
-        for (auto value : subscription_array) {
-          JsonObject& subscription = value.as<JsonObject&>();
-          // TODO: print out the data for testing
-          if(!subscription.containsKey("id") ||
-             !subscription.containsKey("feature_id") ||
-             !subscription.containsKey("type") ||
-             !subscription.containsKey("callback") ||
-             !subscription.containsKey("timeout") ||
-             !subscription.containsKey("calls") ||
-             !subscription.containsKey("errors")) {
-            continue;
-          } else {
-            const char* id = subscription["id"];
-            const char* feature_id = subscription["feature_id"];
-            EventType type = getEventType(subscription["type"]);
-            const char* callback = subscription["callback"];
-            int timeout = subscription["timeout"];
-            int calls = subscription["calls"];
-            int errors = subscription["errors"];
-            feature = getFeature(feature_id);
-            if(feature == NULL) {
-              continue;
-            }
-            s = new RADSubscription(feature, id, type, callback, timeout);
-            _subscriptions.add(s);
-            feature->add(s);
-          }
-        }
-      }
-    }
-  }
+  int restored = restore();
 
   // Prepare the uuid
   uint32_t chipId = ESP.getChipId();
@@ -122,13 +156,14 @@ bool RADConnector::begin(void) {
   (uint16_t) ((chipId >>  8) & 0xff),
   (uint16_t)   chipId        & 0xff);
 
-  // Prepare the info response
-  char buffer[512];
-  sprintf(buffer, _info_template,
-    _name,
-    _uuid
-  );
-  _info = String(buffer);
+  // Prepare the info response, sized for the name it is given
+  size_t size = snprintf(NULL, 0, _info_template, _name, _uuid) + 1;
+  char* buffer = (char*)malloc(size);
+  if(buffer != NULL) {
+    snprintf(buffer, size, _info_template, _name, _uuid);
+    _info = String(buffer);
+    free(buffer);
+  }
 
   // Debugging...
   // Serial.println("ChipId: ");
@@ -140,11 +175,16 @@ bool RADConnector::begin(void) {
   // Serial.println(WiFi.localIP());
 
   // Add the HTTP handlers
-  _http.on(RAD_INFO_PATH, std::bind(&RADConnector::handleInfo, this));
-  _http.on(RAD_FEATURES_PATH, std::bind(&RADConnector::handleFeatures, this));
-  _http.on(RAD_SUBSCRIPTIONS_PATH, std::bind(&RADConnector::handleSubscriptions, this, (RADFeature*)NULL));
-  _http.on(RAD_COMMANDS_PATH, std::bind(&RADConnector::handleCommands, this, (RADFeature*)NULL));
-  _http.on(RAD_EVENTS_PATH, std::bind(&RADConnector::handleEvents, this, (RADFeature*)NULL));
+  on(RAD_INFO_PATH, std::bind(&RADConnector::handleInfo, this));
+  on(RAD_FEATURES_PATH, std::bind(&RADConnector::handleFeatures, this));
+  on(RAD_SUBSCRIPTIONS_PATH, std::bind(&RADConnector::handleSubscriptions, this, (RADFeature*)NULL));
+  on(RAD_COMMANDS_PATH, std::bind(&RADConnector::handleCommands, this, (RADFeature*)NULL));
+  on(RAD_EVENTS_PATH, std::bind(&RADConnector::handleEvents, this, (RADFeature*)NULL));
+  on(RAD_STATS_PATH, std::bind(&RADConnector::handleStats, this));
+  on(RAD_STATE_PATH, std::bind(&RADConnector::handleState, this));
+  on(RAD_LOG_PATH, std::bind(&RADConnector::handleLog, this));
+  on(RAD_API_PATH, std::bind(&RADConnector::handleApi, this));
+  _http.onNotFound(std::bind(&RADConnector::handleNotFound, this));
 
   // Loop through features and add HTTP handlers
   RADFeature* _http_feature = NULL;
@@ -152,15 +192,17 @@ bool RADConnector::begin(void) {
   for(int i = 0; i < _features.size(); i++) {
     _http_feature = _features.get(i);
     snprintf(_path_buffer, sizeof(_path_buffer), RAD_FEATURES_PATH "/%s" RAD_SUBSCRIPTIONS_PATH, _http_feature->getId());
-    _http.on(_path_buffer, std::bind(&RADConnector::handleSubscriptions, this, _http_feature));
+    on(_path_buffer, std::bind(&RADConnector::handleSubscriptions, this, _http_feature));
     snprintf(_path_buffer, sizeof(_path_buffer), RAD_FEATURES_PATH "/%s" RAD_COMMANDS_PATH, _http_feature->getId());
-    _http.on(_path_buffer, std::bind(&RADConnector::handleCommands, this, _http_feature));
+    on(_path_buffer, std::bind(&RADConnector::handleCommands, this, _http_feature));
     snprintf(_path_buffer, sizeof(_path_buffer), RAD_FEATURES_PATH "/%s" RAD_EVENTS_PATH, _http_feature->getId());
-    _http.on(_path_buffer, std::bind(&RADConnector::handleEvents, this, _http_feature));
+    on(_path_buffer, std::bind(&RADConnector::handleEvents, this, _http_feature));
+    snprintf(_path_buffer, sizeof(_path_buffer), RAD_FEATURES_PATH "/%s" RAD_HISTORY_PATH, _http_feature->getId());
+    on(_path_buffer, std::bind(&RADConnector::handleHistory, this, _http_feature));
   }
 
   // Prepare the SSDP configuration
-  _http.collectHeaders(HEADERS, 4);
+  _http.collectHeaders(HEADERS, sizeof(HEADERS) / sizeof(HEADERS[0]));
   _http.begin();
   SSDP.setDeviceType(RAD_DEVICE_TYPE);
   SSDP.setName(_name);
@@ -174,16 +216,62 @@ bool RADConnector::begin(void) {
   SSDP.setManufacturerURL(RAD_INFO_URL);
   SSDP.setHTTPPort(RAD_HTTP_PORT);
   SSDP.begin();
+
+#if RAD_WEBSOCKET
+  _socket.onFrame([this](uint8_t client, bool binary, uint8_t* data, size_t len) {
+    handleFrame(client, binary, data, len);
+  });
+  _socket.begin();
+  RADFeature::listen([this](RADFeature* feature, EventType event_type, bool has_value,
+                            uint8_t value, const char* body, size_t len) {
+    handleEvent(feature, event_type, has_value, value, body, len);
+  });
+#endif
+
+  // Features are fixed once begin() runs, hash them for ETags and the
+  // DNS-SD summary
+  _featuresHash = hashFeatures();
+  publish();
+#if RAD_MDNS
+  advertise();
+#endif
+
+  // Since millis() starts at reset this is the time to the first request
+  _startupTime = millis();
+  RAD_INFO("RADConnector::begin - restored %d subscriptions, ready after %ld ms",
+           restored, _startupTime);
+  return true;
 }
 
 
 void RADConnector::update(void) {
   // loop
+  _idle = true;
   _http.handleClient();
+#if RAD_WEBSOCKET
+  if(_socket.update()) {
+    _idle = false;
+  }
+#endif
+#if RAD_MDNS
+  MDNS.update();
+#endif
+  yield(); // Allow WiFi stack a chance to run
+
+  // Run at most one deferred command so requests keep being served between them
+  if(runDeferred()) {
+    _idle = false;
+  }
   yield(); // Allow WiFi stack a chance to run
 
   long current = millis();
-  // Check for expired subscriptions
+  // Sample any sensor features
+  for(int i = 0; i < _features.size(); i++) {
+    _features.get(i)->poll(current);
+  }
+  yield(); // Allow WiFi stack a chance to run
+
+  // Check for expired subscriptions and send values held back by an interval
   RADSubscription* s;
   for(int i = 0; i < _subscriptions.size(); i++) {
     s = _subscriptions.get(i);
@@ -191,19 +279,304 @@ void RADConnector::update(void) {
       //Serial.println("Found expired subscription!");
       unsubscribe(i);
       i -= 1;
+    } else if(s->isDue(current)) {
+      s->getFeature()->resend(s);
     }
   }
   yield(); // Allow WiFi stack a chance to run
 
   // Check to see if we need to write to SPIFFS
-  if(_subscriptionsChanged && current - _lastWrite >= RAD_MIN_WRITE_INTERVAL) {
-    // TODO: Write subscriptions to file
-    // Serial.println("Writing subscriptions to file!");
-    _lastWrite = current;
-    _subscriptionsChanged = false;
+  if(_subscriptionsChanged && current - _lastWrite >= RAD_MIN_WRITE_INTERVAL * 1000L) {
+    save();
   }
   yield(); // Allow WiFi stack a chance to run
 
+#if RAD_LOG_SERIAL
+  // Only spend UART time on loops that had no request or command to handle
+  if(_idle) {
+    RADLog::drain(Serial, RAD_LOG_DRAIN);
+  }
+#endif
+}
+
+
+RADDeferredCommand* RADConnector::defer(RADFeature* feature, CommandType command_type,
+                                        PayloadType data_type, uint8_t data) {
+  // Use a free slot, otherwise reuse the oldest finished command
+  RADDeferredCommand* slot = NULL;
+  RADDeferredCommand* d;
+  for(int i = 0; i < RAD_DEFERRED_COMMANDS; i++) {
+    d = &_deferred[i];
+    if(d->state == CommandFree) {
+      slot = d;
+      break;
+    } else if(d->state != CommandQueued &&
+              (slot == NULL || (uint16_t)(_deferredId - d->id) > (uint16_t)(_deferredId - slot->id))) {
+      slot = d;
+    }
+  }
+  if(slot == NULL) {
+    return NULL;
+  }
+  _deferredId += 1;
+  slot->id = _deferredId;
+  slot->state = CommandQueued;
+  slot->feature = feature;
+  slot->type = command_type;
+  slot->dataType = data_type;
+  slot->data = data;
+  return slot;
+}
+
+
+bool RADConnector::runDeferred(void) {
+  // Commands run in the order they were accepted
+  RADDeferredCommand* next = NULL;
+  RADDeferredCommand* d;
+  for(int i = 0; i < RAD_DEFERRED_COMMANDS; i++) {
+    d = &_deferred[i];
+    if(d->state == CommandQueued &&
+       (next == NULL || (uint16_t)(_deferredId - d->id) > (uint16_t)(_deferredId - next->id))) {
+      next = d;
+    }
+  }
+  if(next == NULL) {
+    return false;
+  }
+  bool result = false;
+  if(next->dataType == BoolPayload) {
+    result = execute(next->feature->getId(), next->type, next->data != 0, (RADPayload*)NULL);
+  } else if(next->dataType == BytePayload) {
+    result = execute(next->feature->getId(), next->type, next->data, (RADPayload*)NULL);
+  }
+  next->state = result ? CommandComplete : CommandFailed;
+  next->feature->complete(next->id, next->type, result);
+  return true;
+}
+
+
+void RADConnector::advertise(void) {
+#if RAD_MDNS
+  char buff[RAD_MDNS_TXT_SIZE];
+  snprintf(buff, sizeof(buff), "rad-%06x", ESP.getChipId());
+  if(!MDNS.begin(buff)) {
+    RAD_WARN("RADConnector::advertise - mDNS responder failed to start");
+    return;
+  }
+  MDNS.setInstanceName(_name);
+  MDNS.addService(RAD_MDNS_SERVICE, "tcp", RAD_HTTP_PORT);
+  MDNS.addServiceTxt(RAD_MDNS_SERVICE, "tcp", "uuid", _uuid);
+  snprintf(buff, sizeof(buff), "%08x", _featuresHash);
+  MDNS.addServiceTxt(RAD_MDNS_SERVICE, "tcp", "hash", buff);
+  snprintf(buff, sizeof(buff), "%d", _features.size());
+  MDNS.addServiceTxt(RAD_MDNS_SERVICE, "tcp", "count", buff);
+
+  // Compact list of id:type pairs. A TXT string holds at most 255 bytes
+  // including the key, features that don't fit are left out and controllers
+  // see fewer entries than count and fall back to fetching /features
+  char entry[RAD_MDNS_TXT_SIZE];
+  size_t len = 0;
+  size_t max = RAD_MDNS_TXT_SIZE - strlen("features=");
+  int listed = 0;
+  RADFeature* feature;
+  buff[0] = '\0';
+  for(int i = 0; i < _features.size(); i++) {
+    feature = _features.get(i);
+    int n = snprintf(entry, sizeof(entry), "%s%s:%d", len > 0 ? "," : "", feature->getId(), feature->getType());
+    if(n < 0 || len + n > max) {
+      break;
+    }
+    memcpy(buff + len, entry, n + 1);
+    len += n;
+    listed += 1;
+  }
+  MDNS.addServiceTxt(RAD_MDNS_SERVICE, "tcp", "features", buff);
+  RAD_INFO("RADConnector::advertise - _rad._tcp with %d of %d features", listed, _features.size());
+#endif
+}
+
+
+// Subscriptions are stored as a little-endian binary snapshot:
+//
+//   header:  magic (u32), version (u8), subscription count (u8), records (u16)
+//   record:  sid (36 bytes), feature id length (u8), feature id,
+//            event type (u8), callback length (u8), callback, timeout (i32),
+//            remaining lifetime in ms (i32), calls (i32), errors (i32),
+//            filter (u8), filter value (u8), minimum interval (i32)
+//   footer:  CRC-32 of everything before it (u32)
+//
+// Records are read one at a time straight into new RADSubscription objects so
+// the restore never needs more than a single record in memory.
+
+static bool writeSnapshot(File& f, const void* data, size_t len, uint32_t* crc) {
+  *crc = crc32(*crc, data, len);
+  return f.write((const uint8_t*)data, len) == len;
+}
+
+
+static bool readSnapshot(File& f, void* data, size_t len, uint32_t* crc) {
+  if(f.read((uint8_t*)data, len) != len) {
+    return false;
+  }
+  *crc = crc32(*crc, data, len);
+  return true;
+}
+
+
+bool RADConnector::save(void) {
+  long current = millis();
+  // A failed save waits out the write interval like a successful one, the
+  // changed flag stays set so it is retried then
+  _lastWrite = current;
+  File f = SPIFFS.open(RAD_SUBSCRIPTIONS_TEMP_FILE, "w");
+  if(!f) {
+    RAD_WARN("RADConnector::save - can't open %s", RAD_SUBSCRIPTIONS_TEMP_FILE);
+    return false;
+  }
+  uint32_t crc = 0;
+  uint32_t magic = RAD_SNAPSHOT_MAGIC;
+  uint8_t version = RAD_SNAPSHOT_VERSION;
+  uint16_t records = 0;
+  RADSubscription* s;
+  for(int i = 0; i < _subscriptions.size(); i++) {
+    if(_subscriptions.get(i)->isActive(current)) {
+      records += 1;
+    }
+  }
+  bool ok = writeSnapshot(f, &magic, sizeof(magic), &crc) &&
+            writeSnapshot(f, &version, sizeof(version), &crc) &&
+            writeSnapshot(f, &_subscriptionCount, sizeof(_subscriptionCount), &crc) &&
+            writeSnapshot(f, &records, sizeof(records), &crc);
+  for(int i = 0; ok && i < _subscriptions.size(); i++) {
+    s = _subscriptions.get(i);
+    if(!s->isActive(current)) continue;
+    const char* feature_id = s->getFeature()->getId();
+    uint8_t feature_len = strlen(feature_id);
+    uint8_t type = s->getType();
+    uint8_t callback_len = strlen(s->getCallback());
+    int32_t timeout = s->getTimeout();
+    int32_t remaining = s->getRemaining(current);
+    int32_t calls = s->getCalls();
+    int32_t errors = s->getErrors();
+    uint8_t filter = s->getFilter();
+    uint8_t threshold = s->getThreshold();
+    int32_t interval = s->getInterval();
+    ok = writeSnapshot(f, s->getSid(), SID_UUID_SIZE - 1, &crc) &&
+         writeSnapshot(f, &feature_len, sizeof(feature_len), &crc) &&
+         writeSnapshot(f, feature_id, feature_len, &crc) &&
+         writeSnapshot(f, &type, sizeof(type), &crc) &&
+         writeSnapshot(f, &callback_len, sizeof(callback_len), &crc) &&
+         writeSnapshot(f, s->getCallback(), callback_len, &crc) &&
+         writeSnapshot(f, &timeout, sizeof(timeout), &crc) &&
+         writeSnapshot(f, &remaining, sizeof(remaining), &crc) &&
+         writeSnapshot(f, &calls, sizeof(calls), &crc) &&
+         writeSnapshot(f, &errors, sizeof(errors), &crc) &&
+         writeSnapshot(f, &filter, sizeof(filter), &crc) &&
+         writeSnapshot(f, &threshold, sizeof(threshold), &crc) &&
+         writeSnapshot(f, &interval, sizeof(interval), &crc);
+  }
+  ok = ok && f.write((const uint8_t*)&crc, sizeof(crc)) == sizeof(crc);
+  f.close();
+
+  // Replace the previous snapshot only once the new one is complete
+  if(ok) {
+    SPIFFS.remove(RAD_SUBSCRIPTIONS_FILE);
+    ok = SPIFFS.rename(RAD_SUBSCRIPTIONS_TEMP_FILE, RAD_SUBSCRIPTIONS_FILE);
+  } else {
+    SPIFFS.remove(RAD_SUBSCRIPTIONS_TEMP_FILE);
+  }
+  if(ok) {
+    _subscriptionsChanged = false;
+  } else {
+    RAD_WARN("RADConnector::save - snapshot not written, retrying in %d s", RAD_MIN_WRITE_INTERVAL);
+  }
+  return ok;
+}
+
+
+int RADConnector::restore(void) {
+  File f = SPIFFS.open(RAD_SUBSCRIPTIONS_FILE, "r");
+  if(!f) {
+    return 0;
+  }
+  long current = millis();
+  uint32_t crc = 0;
+  uint32_t magic;
+  uint8_t version;
+  uint8_t count;
+  uint16_t records;
+  if(!readSnapshot(f, &magic, sizeof(magic), &crc) ||
+     !readSnapshot(f, &version, sizeof(version), &crc) ||
+     !readSnapshot(f, &count, sizeof(count), &crc) ||
+     !readSnapshot(f, &records, sizeof(records), &crc) ||
+     magic != RAD_SNAPSHOT_MAGIC || version < 1 || version > RAD_SNAPSHOT_VERSION) {
+    f.close();
+    return 0;
+  }
+
+  int first = _subscriptions.size();
+  bool ok = true;
+  char sid[SID_UUID_SIZE];
+  char feature_id[256];
+  char callback[MAX_CALLBACK_SIZE];
+  uint8_t len, type;
+  int32_t timeout, remaining, calls, errors;
+  uint8_t filter, threshold;
+  int32_t interval;
+  RADFeature* feature;
+  RADSubscription* s;
+  for(uint16_t i = 0; ok && i < records; i++) {
+    ok = readSnapshot(f, sid, SID_UUID_SIZE - 1, &crc) &&
+         readSnapshot(f, &len, sizeof(len), &crc) &&
+         readSnapshot(f, feature_id, len, &crc) &&
+         readSnapshot(f, &type, sizeof(type), &crc);
+    // Strings are only terminated once their length is known to be valid
+    if(!ok) break;
+    feature_id[len] = '\0';
+    sid[SID_UUID_SIZE - 1] = '\0';
+    ok = readSnapshot(f, &len, sizeof(len), &crc) && len < sizeof(callback) &&
+         readSnapshot(f, callback, len, &crc) &&
+         readSnapshot(f, &timeout, sizeof(timeout), &crc) &&
+         readSnapshot(f, &remaining, sizeof(remaining), &crc) &&
+         readSnapshot(f, &calls, sizeof(calls), &crc) &&
+         readSnapshot(f, &errors, sizeof(errors), &crc);
+    if(!ok) break;
+    callback[len] = '\0';
+    // Version 1 snapshots have no filters
+    filter = NullFilter;
+    threshold = 0;
+    interval = 0;
+    if(version >= 2) {
+      ok = ok && readSnapshot(f, &filter, sizeof(filter), &crc) &&
+           readSnapshot(f, &threshold, sizeof(threshold), &crc) &&
+           readSnapshot(f, &interval, sizeof(interval), &crc);
+    }
+    if(!ok) break;
+    feature = getFeature(feature_id);
+    if(feature == NULL || remaining <= 0) {
+      continue;
+    }
+    s = new RADSubscription(feature, sid, (EventType)type, callback, timeout, calls, errors);
+    s->setRemaining(current, remaining);
+    s->filter((FilterType)filter, threshold, interval);
+    _subscriptions.add(s);
+    feature->add(s);
+  }
+  uint32_t stored;
+  ok = ok && f.read((uint8_t*)&stored, sizeof(stored)) == sizeof(stored) && stored == crc;
+  f.close();
+
+  // Drop everything from a truncated or corrupt snapshot
+  if(!ok) {
+    while(_subscriptions.size() > first) {
+      s = _subscriptions.remove(_subscriptions.size() - 1);
+      s->getFeature()->remove(s);
+      delete s;
+    }
+    return 0;
+  }
+  _subscriptionCount = count;
+  return _subscriptions.size() - first;
 }
 
 
@@ -219,8 +592,22 @@ RADFeature* RADConnector::getFeature(const char* feature_id) {
 }
 
 
+RADFeature* RADConnector::getFeature(const char* feature_id, size_t len) {
+  RADFeature* feature = NULL;
+  const char* id;
+  for(int i = 0; i < _features.size(); i++) {
+    id = _features.get(i)->getId();
+    if(strncmp(id, feature_id, len) == 0 && id[len] == '\0') {
+      feature = _features.get(i);
+      break;
+    }
+  }
+  return feature;
+}
+
+
 void RADConnector::handleInfo(void) {
-  Serial.println("/");
+  RAD_DEBUG("RADConnector::handleInfo");
   if(_http.method() == HTTP_GET) {
     _http.send(200, "application/json", _info);
   } else {
@@ -229,10 +616,197 @@ void RADConnector::handleInfo(void) {
 }
 
 
+uint32_t RADConnector::hashFeatures(void) {
+  // Covers everything the features document is built from, including the
+  // format it is rendered in
+  uint16_t version = RAD_DOCUMENT_VERSION;
+  uint32_t hash = crc32(0, &version, sizeof(version));
+  RADFeature* feature;
+  uint8_t flags[2];
+  for(int i = 0; i < _features.size(); i++) {
+    feature = _features.get(i);
+    hash = crc32(hash, feature->getId(), strlen(feature->getId()) + 1);
+    hash = crc32(hash, feature->getName(), strlen(feature->getName()) + 1);
+    flags[0] = feature->getType();
+    flags[1] = feature->getHistory() != NULL;
+    hash = crc32(hash, flags, sizeof(flags));
+  }
+  return hash;
+}
+
+
+// Appends s to doc as the contents of a JSON string
+static void appendEscaped(String& doc, const char* s) {
+  char hex[7];
+  for(; *s; s++) {
+    if(*s == '"' || *s == '\\') {
+      doc += '\\';
+      doc += *s;
+    } else if((uint8_t)*s < 0x20) {
+      snprintf(hex, sizeof(hex), "\\u%04x", (uint8_t)*s);
+      doc += hex;
+    } else {
+      doc += *s;
+    }
+  }
+}
+
+
+String RADConnector::describe(void) {
+  // Swagger 2.0 description of this device, the fixed routes plus the
+  // commands, payload and routes of every registered feature. Everything is
+  // appended to doc so long ids and names can't truncate an entry
+  static const CommandType commands[] = {Get, Set};
+  RADFeature* feature;
+  String doc;
+  doc += "{\"swagger\":\"2.0\",\"info\":{\"title\":\"";
+  appendEscaped(doc, _name);
+  doc += "\",\"version\":\"" RAD_MODEL_NUM "\",\"description\":\"" RAD_MODEL_NAME " uuid:";
+  doc += _uuid;
+  doc += "\"},\"basePath\":\"/\",\"schemes\":[\"http\"],"
+         "\"consumes\":[\"application/json\"],\"produces\":[\"application/json\"],\"paths\":{";
+  doc += API_PATHS;
+  for(int i = 0; i < _features.size(); i++) {
+    feature = _features.get(i);
+    doc += ",\"" RAD_FEATURES_PATH "/";
+    appendEscaped(doc, feature->getId());
+    doc += RAD_COMMANDS_PATH "\":{\"post\":{\"operationId\":\"";
+    appendEscaped(doc, feature->getId());
+    doc += "Command\",\"summary\":\"";
+    appendEscaped(doc, feature->getName());
+    doc += "\",\"parameters\":[{\"name\":\"command\",\"in\":\"body\",\"required\":true,"
+           "\"schema\":{\"$ref\":\"#/definitions/";
+    appendEscaped(doc, feature->getId());
+    doc += "Command\"}}],\"responses\":{\"200\":{\"description\":\"Command result\"},"
+           "\"202\":{\"description\":\"Command queued\"}}}}";
+    doc += ",\"" RAD_FEATURES_PATH "/";
+    appendEscaped(doc, feature->getId());
+    doc += RAD_SUBSCRIPTIONS_PATH "\":{\"$ref\":\"#/paths/~1subscriptions\"}";
+    if(feature->getHistory() != NULL) {
+      doc += ",\"" RAD_FEATURES_PATH "/";
+      appendEscaped(doc, feature->getId());
+      doc += RAD_HISTORY_PATH "\":{\"get\":{\"operationId\":\"";
+      appendEscaped(doc, feature->getId());
+      doc += "History\",\"responses\":{\"200\":{\"description\":\"Recent values\"}}}}";
+    }
+  }
+  doc += "},\"definitions\":{\"FeatureId\":{\"type\":\"string\",\"enum\":[";
+  for(int i = 0; i < _features.size(); i++) {
+    doc += i == 0 ? "\"" : ",\"";
+    appendEscaped(doc, _features.get(i)->getId());
+    doc += "\"";
+  }
+  doc += "]},\"Command\":{\"type\":\"object\",\"required\":[\"feature_id\",\"command_type\"],\"properties\":{"
+         "\"feature_id\":{\"$ref\":\"#/definitions/FeatureId\"},"
+         "\"command_type\":{\"type\":\"string\",\"enum\":[\"Get\",\"Set\"]},\"data\":{}}},";
+  doc += API_DEFINITIONS;
+  for(int i = 0; i < _features.size(); i++) {
+    feature = _features.get(i);
+    doc += ",\"";
+    appendEscaped(doc, feature->getId());
+    doc += "Command\":{\"type\":\"object\",\"title\":\"";
+    appendEscaped(doc, feature->getName());
+    doc += "\",\"x-rad-feature-type\":\"";
+    doc += sendFeatureType(feature->getType());
+    doc += "\",\"required\":[\"command_type\"],\"properties\":{\"command_type\":{\"type\":\"string\",\"enum\":[";
+    bool first = true;
+    for(size_t c = 0; c < sizeof(commands) / sizeof(commands[0]); c++) {
+      if(feature->supports(commands[c])) {
+        doc += first ? "\"" : ",\"";
+        doc += sendCommandType(commands[c]);
+        doc += "\"";
+        first = false;
+      }
+    }
+    doc += "]}";
+    if(feature->getPayloadType() == BoolPayload) {
+      doc += ",\"data\":{\"type\":\"boolean\"}";
+    } else if(feature->getPayloadType() == BytePayload) {
+      doc += ",\"data\":{\"type\":\"integer\",\"minimum\":0,\"maximum\":255}";
+    }
+    doc += "}}";
+  }
+  doc += "}}";
+  return doc;
+}
+
+
+void RADConnector::publish(void) {
+  // The description only changes with the firmware, so it is compressed
+  // once under a name derived from its contents and reused on later boots
+  String doc = describe();
+  _apiHash = crc32(0, doc.c_str(), doc.length());
+  snprintf(_apiFile, sizeof(_apiFile), RAD_API_FILE_PREFIX "%08x.json.gz", _apiHash);
+  Dir dir = SPIFFS.openDir(RAD_API_FILE_PREFIX);
+  while(dir.next()) {
+    if(strcmp(dir.fileName().c_str(), _apiFile) != 0) {
+      SPIFFS.remove(dir.fileName());
+    }
+  }
+  if(SPIFFS.exists(_apiFile)) {
+    return;
+  }
+  size_t written = 0;
+  File f = SPIFFS.open(_apiFile, "w");
+  if(f) {
+    written = RADDeflate::gzip((const uint8_t*)doc.c_str(), doc.length(), f);
+    f.close();
+  }
+  if(written == 0) {
+    SPIFFS.remove(_apiFile);
+    RAD_WARN("RADConnector::publish - failed to write %s", _apiFile);
+    return;
+  }
+  RAD_INFO("RADConnector::publish - API description %u bytes, %u compressed",
+           doc.length(), written);
+}
+
+
+void RADConnector::handleApi(void) {
+  RAD_DEBUG("RADConnector::handleApi");
+  if(_http.method() != HTTP_GET) {
+    _http.send(405);
+    return;
+  }
+  char etag[16];
+  char cache[32];
+  snprintf(etag, sizeof(etag), "\"%08x\"", _apiHash);
+  snprintf(cache, sizeof(cache), "max-age=%d", RAD_API_MAX_AGE);
+  _http.sendHeader(HEADER_ETAG, etag);
+  _http.sendHeader(HEADER_CACHE_CONTROL, cache);
+  _http.sendHeader("Vary", HEADER_ACCEPT_ENCODING);
+  if(strstr(_http.header(HEADER_IF_NONE_MATCH).c_str(), etag) != NULL) {
+    _http.send(304);
+    return;
+  }
+  // Clients that don't take gzip, or a missing file, get the document
+  // built on demand instead
+  File f;
+  if(strstr(_http.header(HEADER_ACCEPT_ENCODING).c_str(), "gzip") != NULL) {
+    f = SPIFFS.open(_apiFile, "r");
+  }
+  if(f) {
+    _http.streamFile(f, "application/json");
+    f.close();
+  } else {
+    _http.send(200, "application/json", describe());
+  }
+}
+
+
 void RADConnector::handleFeatures() {
-  Serial.println("RADConnector::handleFeatures");
+  RAD_DEBUG("RADConnector::handleFeatures");
   int code = 200;
   if(_http.method() == HTTP_GET) {
+    // The document only changes with the firmware, so a matching ETag
+    // skips building it altogether
+    char etag[16];
+    snprintf(etag, sizeof(etag), "\"%08x\"", _featuresHash);
+    _http.sendHeader(HEADER_ETAG, etag);
+    if(strstr(_http.header(HEADER_IF_NONE_MATCH).c_str(), etag) != NULL) {
+      _http.send(304);
+      return;
+    }
     // Prepare the JSON response
     StaticJsonBuffer<1024> featuresBuffer;
     char featuresString[1024];
@@ -255,6 +829,10 @@ void RADConnector::handleFeatures() {
       links_json["subscriptions"] = String(linkBuff);
       snprintf(linkBuff, sizeof(linkBuff), RAD_FEATURES_PATH "/%s" RAD_EVENTS_PATH, feature->getId());
       links_json["events"] = String(linkBuff);
+      if(feature->getHistory() != NULL) {
+        snprintf(linkBuff, sizeof(linkBuff), RAD_FEATURES_PATH "/%s" RAD_HISTORY_PATH, feature->getId());
+        links_json["history"] = String(linkBuff);
+      }
     }
     features.printTo(featuresString, sizeof(featuresString));
     _http.send(code, "application/json", featuresString);
@@ -265,7 +843,7 @@ void RADConnector::handleFeatures() {
 
 
 void RADConnector::handleSubscriptions(RADFeature* feature) {
-  Serial.println("RADConnector::handleSubscriptions");
+  RAD_DEBUG("RADConnector::handleSubscriptions");
   int code = 200;
   long current = millis();
   if(_http.method() == HTTP_GET) {
@@ -287,6 +865,17 @@ void RADConnector::handleSubscriptions(RADFeature* feature) {
         subscription_json["callback"] = subscription->getCallback();
         subscription_json["timeout"] = subscription->getTimeout();
         subscription_json["duration"] = subscription->getDuration(current);
+        subscription_json["calls"] = subscription->getCalls();
+        subscription_json["errors"] = subscription->getErrors();
+        if(subscription->getFilter() != NullFilter) {
+          subscription_json["filter"] = sendFilterType(subscription->getFilter());
+        }
+        if(subscription->getFilter() == EqualsFilter || subscription->getFilter() == CrossesFilter) {
+          subscription_json["value"] = subscription->getThreshold();
+        }
+        if(subscription->getInterval() > 0) {
+          subscription_json["interval"] = subscription->getInterval();
+        }
       }
     }
     subscriptions.printTo(subscriptionsString, sizeof(subscriptionsString));
@@ -294,7 +883,7 @@ void RADConnector::handleSubscriptions(RADFeature* feature) {
   // POST Method
   } else if(_http.method() == HTTP_POST) {
     String message = "";
-    StaticJsonBuffer<255> jsonBuffer;
+    StaticJsonBuffer<512> jsonBuffer;
     JsonObject& root = jsonBuffer.parseObject(_http.arg("plain"));
     if(feature == NULL && !root.containsKey("feature_id")) {
       code = 400;
@@ -312,6 +901,24 @@ void RADConnector::handleSubscriptions(RADFeature* feature) {
       if(root.containsKey("timeout")) {
         timeout = root["timeout"];
       }
+      // Optional predicate on the event value and minimum seconds between
+      // notifications
+      FilterType filter = NullFilter;
+      int threshold = 0;
+      int interval = 0;
+      if(root.containsKey("filter")) {
+        const char* filter_name = root["filter"];
+        filter = filter_name != NULL ? getFilterType(filter_name) : NullFilter;
+      }
+      bool has_value = root.containsKey("value");
+      if(has_value && root["value"].is<bool>()) {
+        threshold = root["value"].as<bool>() ? 255 : 0;
+      } else if(has_value) {
+        threshold = root["value"];
+      }
+      if(root.containsKey("interval")) {
+        interval = root["interval"];
+      }
       RADFeature* featureTarget;
       if(feature == NULL) {
         const char* feature_id = root["feature_id"];
@@ -328,8 +935,21 @@ void RADConnector::handleSubscriptions(RADFeature* feature) {
       } else if(timeout < RAD_MIN_TIMEOUT) {
         code = 400;
         message = "{\"error\": \"The timeout property can not be less than 600 seconds.\"}";
+      } else if(root.containsKey("filter") && filter == NullFilter) {
+        code = 400;
+        message = "{\"error\": \"Unsuported filter.\"}";
+      } else if((filter == EqualsFilter || filter == CrossesFilter) && !has_value) {
+        code = 400;
+        message = "{\"error\": \"Missing required property 'value'.\"}";
+      } else if(threshold < 0 || threshold > 255) {
+        code = 400;
+        message = "{\"error\": \"The value property must be between 0 and 255.\"}";
+      } else if(interval < 0) {
+        code = 400;
+        message = "{\"error\": \"The interval property can not be negative.\"}";
       } else {
-        RADSubscription* subscription = subscribe(featureTarget, type, callback, timeout);
+        RADSubscription* subscription = subscribe(featureTarget, type, callback, timeout,
+                                                  filter, threshold, interval);
         char sid[100];
         snprintf(sid, sizeof(sid), "uuid:%s", subscription->getSid());
         _http.sendHeader("SID", sid);
@@ -344,125 +964,492 @@ void RADConnector::handleSubscriptions(RADFeature* feature) {
 
 
 void RADConnector::handleCommands(RADFeature* feature) {
-  Serial.println("RADConnector::handleCommands");
-  int code = 200;
-  uint8_t value;
-  bool result = false;
-  RADPayload* response = NULL;
-  String message = "";
+  RAD_DEBUG("RADConnector::handleCommands");
   if(_http.method() == HTTP_POST) {
-    Serial.println("RADConnector::handleCommands - POST");
+    RAD_DEBUG("RADConnector::handleCommands - POST");
     StaticJsonBuffer<255> jsonBuffer;
-    JsonObject& root = jsonBuffer.parseObject(_http.arg("plain"));
-    if(feature == NULL && !root.containsKey("feature_id")) {
-      code = 400;
-      message = "{\"error\": \"Missing required property, 'feature_id'.\"}";
-    }else  if(!root.containsKey("command_type")) {
-      code = 400;
-      message = "{\"error\": \"Missing required property, 'command_type'.\"}";
+    RADCommand command;
+    RADPayload response;
+    uint16_t command_id;
+    char message[160];
+    const String& body = _http.arg("plain");
+    int code = 400;
+    if(!parseCommand(body.c_str(), body.length(), &command) &&
+       !parseCommandJson(jsonBuffer.parseObject(body), &command)) {
+      snprintf(message, sizeof(message), "{\"error\": \"Invalid command body.\"}");
     } else {
-      RADFeature* featureTarget;
-      if(feature == NULL) {
-        const char* feature_id = root["feature_id"];
-        featureTarget = getFeature(feature_id);
-      } else {
-        featureTarget = feature;
+      code = dispatch(feature, &command, &response, &command_id, message, sizeof(message));
+    }
+    if(code == 202) {
+      char location[32];
+      snprintf(location, sizeof(location), RAD_COMMANDS_PATH "/%u", command_id);
+      _http.sendHeader("Location", location);
+    }
+    _http.send(code, "application/json", message);
+  } else {
+    _http.send(405);
+  }
+}
+
+
+int RADConnector::dispatch(RADFeature* feature, RADCommand* command, RADPayload* response,
+                           uint16_t* command_id, char* message, size_t len) {
+  // Runs a parsed command against feature, or the feature it names, and
+  // returns the HTTP status. The body goes to message, a Get result to
+  // response and the id of a queued command to command_id
+  int code = 200;
+  bool result = false;
+  message[0] = '\0';
+  response->type = NullPayload;
+  if(feature == NULL && !command->hasFeatureId) {
+    code = 400;
+    snprintf(message, len, "{\"error\": \"Missing required property, 'feature_id'.\"}");
+  } else if(!command->hasType) {
+    code = 400;
+    snprintf(message, len, "{\"error\": \"Missing required property, 'command_type'.\"}");
+  } else {
+    RADFeature* featureTarget = NULL;
+    if(feature == NULL) {
+      if(command->featureId != NULL) {
+        featureTarget = getFeature(command->featureId, command->featureIdLen);
       }
-      if(featureTarget == NULL) {
-        code = 400;
-        message = "{\"error\": \"Invalid 'feature_id' value.\"}";
-      } else {
-        CommandType type = getCommandType(root["command_type"]);
-        switch(type) {
-          case Set:
-            Serial.println("RADConnector::handleCommands - case Set:");
-            if(!root.containsKey("data")) {
-              code = 400;
-              message = "{\"error\": \"Missing required property, 'data'.\"}";
+    } else {
+      featureTarget = feature;
+    }
+    if(featureTarget == NULL) {
+      code = 400;
+      snprintf(message, len, "{\"error\": \"Invalid 'feature_id' value.\"}");
+    } else {
+      switch(command->type) {
+        case Set:
+          RAD_DEBUG("RADConnector::dispatch - case Set:");
+          if(!featureTarget->supports(Set)) {
+            // Rejected before anything is queued, a deferred command would
+            // only fail later
+            code = 400;
+            snprintf(message, len, "{\"error\": \"Unsupported command for this feature.\"}");
+          } else if(!command->hasData) {
+            code = 400;
+            snprintf(message, len, "{\"error\": \"Missing required property, 'data'.\"}");
+          } else if(command->dataType != featureTarget->getPayloadType()) {
+            code = 400;
+            snprintf(message, len, "{\"error\": \"Invalid 'data' value.\"}");
+          } else if(featureTarget->isDeferred()) {
+            RADDeferredCommand* deferred = defer(featureTarget, Set, command->dataType, command->data);
+            if(deferred == NULL) {
+              code = 503;
+              snprintf(message, len, "{\"error\": \"Too many commands are pending.\"}");
             } else {
-              if(root["data"].is<bool>()) {
-                result = execute(featureTarget->getId(), Set, (bool)root["data"].as<bool>(), (RADPayload*)NULL);
-              } else if(root["data"].is<int>()) {
-                // TODO: handle 
-              } else if(root["data"].is<char*>()) {
-                // TODO: handle base64 encoded data
-              }
+              code = 202;
+              *command_id = deferred->id;
+              snprintf(message, len, "{\"command_id\": %u, \"links\": {\"status\": \"" RAD_COMMANDS_PATH "/%u\"}}",
+                       deferred->id, deferred->id);
             }
-            break;
-          case Get:
-            response = new RADPayload();
-            result = execute(featureTarget->getId(), Get, response);
-            if(result && response != NULL) {
-              switch(response->type) {
-                case BoolPayload:
-                  if(response->data[0]) {
-                    message = "{\"data\": true}";
-                  } else {
-                    message = "{\"data\": false}";
-                  }
-                  break;
-                case BytePayload:
-                  char buff[100];
-                  snprintf(buff, sizeof(buff), "{\"data\": %d}", response->data[0]);
-                  message = buff;
-                  break;
-                case ByteArrayPayload:
-                  // TODO: handle get payload
-                  break;
-              }
+          } else {
+            if(command->dataType == BoolPayload) {
+              result = execute(featureTarget->getId(), Set, command->data != 0, (RADPayload*)NULL);
             } else {
+              result = execute(featureTarget->getId(), Set, (uint8_t)command->data, (RADPayload*)NULL);
+            }
+            if(!result) {
               code = 500;
-              message = "{\"error\": \"Failure.\"}";
+              snprintf(message, len, "{\"error\": \"Failure.\"}");
             }
-            break;
-          default:
+          }
+          break;
+        case Get:
+          if(!featureTarget->supports(Get)) {
             code = 400;
-            message = "{\"error\": \"Unsuported command type.\"}";
+            snprintf(message, len, "{\"error\": \"Unsupported command for this feature.\"}");
             break;
-        }
+          }
+          result = execute(featureTarget->getId(), Get, response);
+          if(result) {
+            switch(response->type) {
+              case BoolPayload:
+                if(response->data[0]) {
+                  snprintf(message, len, "{\"data\": true}");
+                } else {
+                  snprintf(message, len, "{\"data\": false}");
+                }
+                break;
+              case BytePayload:
+                snprintf(message, len, "{\"data\": %d}", response->data[0]);
+                break;
+              case ByteArrayPayload:
+                // Byte arrays have no JSON encoding in the API yet, the
+                // payload is owned by the caller so free it here
+                free(response->data);
+                response->type = NullPayload;
+                code = 501;
+                snprintf(message, len, "{\"error\": \"Byte array data is not supported.\"}");
+                break;
+            }
+          } else {
+            code = 500;
+            snprintf(message, len, "{\"error\": \"Failure.\"}");
+          }
+          break;
+        default:
+          code = 400;
+          snprintf(message, len, "{\"error\": \"Unsuported command type.\"}");
+          break;
       }
     }
-    _http.send(code, "application/json", message);
+  }
+  return code;
+}
+
+
+int RADConnector::indexOf(RADFeature* feature) {
+  for(int i = 0; i < _features.size(); i++) {
+    if(_features.get(i) == feature) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+
+#if RAD_WEBSOCKET
+// Text frames carry the same JSON as POST /commands and are answered with
+//   {"feature_id": ..., "status": <HTTP status>, <response body>}
+// Binary frames are [command_type, feature index, data] with data only used
+// by Set and taken as the feature's payload type, they are answered with
+//   [command_type, feature index, status high, status low, value or command id]
+// Either way the client is sent the events of every feature it has sent a
+// command to, in the same encoding as its last frame.
+void RADConnector::handleFrame(uint8_t client, bool binary, uint8_t* data, size_t len) {
+  RAD_DEBUG("RADConnector::handleFrame");
+  RADCommand command;
+  RADPayload response;
+  RADFeature* feature = NULL;
+  uint16_t command_id = 0;
+  char message[160];
+  int code = 400;
+  int retry = 0;
+  response.type = NullPayload;
+  // Every frame is admitted like a request, keyed on the socket's peer
+  bool admitted = RADLimiter::admit((uint32_t)_socket.remoteIP(client), millis(), &retry);
+  if(binary) {
+    if(!admitted) {
+      code = 429;
+    } else if(len >= 2 && data[1] < _features.size()) {
+      feature = _features.get(data[1]);
+      command.hasFeatureId = false;
+      command.featureId = NULL;
+      command.featureIdLen = 0;
+      command.hasType = true;
+      command.type = (CommandType)data[0];
+      command.hasData = len >= 3;
+      command.dataType = feature->getPayloadType() == BytePayload ? BytePayload : BoolPayload;
+      command.data = len >= 3 ? data[2] : 0;
+      if(command.dataType == BoolPayload && command.data != 0) {
+        command.data = 255;
+      }
+      code = dispatch(feature, &command, &response, &command_id, message, sizeof(message));
+      _socket.watch(client, data[1]);
+    }
+    uint8_t reply[6] = {data[0], (uint8_t)(len >= 2 ? data[1] : 0xff), (uint8_t)(code >> 8), (uint8_t)(code & 0xff)};
+    size_t n = 4;
+    if(code == 202) {
+      reply[n++] = command_id >> 8;
+      reply[n++] = command_id & 0xff;
+    } else if(code == 429) {
+      reply[n++] = retry >> 8;
+      reply[n++] = retry & 0xff;
+    } else if(response.type == BoolPayload || response.type == BytePayload) {
+      reply[n++] = response.data[0];
+    }
+    _socket.send(client, true, reply, n);
+    return;
+  }
+
+  StaticJsonBuffer<255> jsonBuffer;
+  command.hasFeatureId = false;
+  if(!admitted) {
+    code = 429;
+    snprintf(message, sizeof(message), "{\"error\": \"Too many requests.\", \"retry_after\": %d}", retry);
+  } else if(!parseCommand((const char*)data, len, &command) &&
+            !parseCommandJson(jsonBuffer.parseObject((char*)data), &command)) {
+    snprintf(message, sizeof(message), "{\"error\": \"Invalid command body.\"}");
   } else {
+    code = dispatch(NULL, &command, &response, &command_id, message, sizeof(message));
+  }
+  if(command.hasFeatureId && command.featureId != NULL) {
+    feature = getFeature(command.featureId, command.featureIdLen);
+  }
+  char reply[RAD_WEBSOCKET_MAX_FRAME];
+  int n;
+  if(feature != NULL) {
+    _socket.watch(client, indexOf(feature));
+    n = snprintf(reply, sizeof(reply), "{\"feature_id\":\"%s\",\"status\":%d", feature->getId(), code);
+  } else {
+    n = snprintf(reply, sizeof(reply), "{\"status\":%d", code);
+  }
+  // Fold the response body into the same object
+  if(message[0] == '{' && message[1] != '}') {
+    n += snprintf(reply + n, sizeof(reply) - n, ",%s", message + 1);
+  } else {
+    n += snprintf(reply + n, sizeof(reply) - n, "}");
+  }
+  _socket.send(client, false, (uint8_t*)reply, n < (int)sizeof(reply) ? n : sizeof(reply) - 1);
+}
+
+
+void RADConnector::handleEvent(RADFeature* feature, EventType event_type, bool has_value,
+                               uint8_t value, const char* body, size_t len) {
+  // Binary clients get [0x80 | event_type, feature index, value], the JSON
+  // body is only rendered once the first text client wants it
+  int index = indexOf(feature);
+  uint8_t compact[3] = {(uint8_t)(0x80 | event_type), (uint8_t)index, value};
+  char text[RAD_WEBSOCKET_MAX_FRAME];
+  int n = 0;
+  for(uint8_t c = 0; c < RAD_WEBSOCKET_MAX_CLIENTS; c++) {
+    if(!_socket.isWatching(c, index)) {
+      continue;
+    }
+    if(_socket.isBinary(c)) {
+      _socket.send(c, true, compact, has_value ? 3 : 2);
+    } else {
+      if(n == 0) {
+        n = snprintf(text, sizeof(text), "{\"feature_id\":\"%s\",%.*s", feature->getId(),
+                     (int)(len - 1), body + 1);
+        if(n >= (int)sizeof(text)) {
+          n = sizeof(text) - 1;
+        }
+      }
+      _socket.send(c, false, (uint8_t*)text, n);
+    }
+  }
+}
+#endif
+
+
+void RADConnector::handleCommandStatus(uint16_t command_id) {
+  RAD_DEBUG("RADConnector::handleCommandStatus");
+  if(_http.method() != HTTP_GET) {
+    _http.send(405);
+    return;
+  }
+  RADDeferredCommand* d;
+  for(int i = 0; i < RAD_DEFERRED_COMMANDS; i++) {
+    d = &_deferred[i];
+    if(d->state != CommandFree && d->id == command_id) {
+      char buff[255];
+      snprintf(buff, sizeof(buff),
+               "{\"command_id\": %u, \"feature_id\": \"%s\", \"command_type\": \"%s\", \"state\": \"%s\"}",
+               d->id, d->feature->getId(), sendCommandType(d->type), sendCommandState(d->state));
+      _http.send(200, "application/json", buff);
+      return;
+    }
+  }
+  _http.send(404, "application/json", "{\"error\": \"Unknown command id.\"}");
+}
+
+
+void RADConnector::handleStats(void) {
+  RAD_DEBUG("RADConnector::handleStats");
+  if(_http.method() != HTTP_GET) {
+    _http.send(405);
+    return;
+  }
+  char buff[255];
+  snprintf(buff, sizeof(buff),
+           "{\"admitted\": %u, \"rejected\": %u, \"rejected_client\": %u, \"rejected_global\": %u, \"clients\": %u}",
+           RADLimiter::getAdmitted(), RADLimiter::getRejectedClient() + RADLimiter::getRejectedGlobal(),
+           RADLimiter::getRejectedClient(), RADLimiter::getRejectedGlobal(), RADLimiter::getClients());
+  _http.send(200, "application/json", buff);
+}
+
+
+void RADConnector::handleState(void) {
+  RAD_DEBUG("RADConnector::handleState");
+  if(_http.method() != HTTP_GET) {
     _http.send(405);
+    return;
+  }
+  // Read every feature once, keeping the payload type and value so the
+  // ETag can be computed before anything is sent
+  int count = _features.size();
+  uint8_t* state = (uint8_t*)malloc(count * 2 + 1);
+  if(state == NULL) {
+    _http.send(500, "application/json", "{\"error\": \"Failure.\"}");
+    return;
+  }
+  RADPayload response;
+  for(int i = 0; i < count; i++) {
+    state[i * 2] = NullPayload;
+    state[i * 2 + 1] = 0;
+    if(_features.get(i)->execute(Get, NULL, &response)) {
+      if(response.type == ByteArrayPayload) {
+        // Byte arrays have no JSON encoding in the API yet, so they are
+        // reported as null and left out of the ETag like unreadable features
+        free(response.data);
+      } else if(response.len == 1) {
+        state[i * 2] = response.type;
+        state[i * 2 + 1] = response.data[0];
+      }
+    }
+  }
+  char buff[256];
+  snprintf(buff, sizeof(buff), "\"%08x\"", crc32(_featuresHash, state, count * 2));
+  _http.sendHeader(HEADER_ETAG, buff);
+  if(strstr(_http.header(HEADER_IF_NONE_MATCH).c_str(), buff) != NULL) {
+    free(state);
+    _http.send(304);
+    return;
+  }
+
+  // Stream the response as {"feature_id": value, ...}, features without a
+  // readable state are null
+  size_t len = 0;
+  _http.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _http.send(200, "application/json", "");
+  len += snprintf(buff + len, sizeof(buff) - len, "{");
+  for(int i = 0; i < count; i++) {
+    const char* sep = i == 0 ? "" : ",";
+    const char* id = _features.get(i)->getId();
+    if(len + strlen(id) + 16 > sizeof(buff)) {
+      _http.sendContent(buff);
+      len = 0;
+    }
+    if(state[i * 2] == BoolPayload) {
+      len += snprintf(buff + len, sizeof(buff) - len, "%s\"%s\":%s", sep, id, state[i * 2 + 1] ? "true" : "false");
+    } else if(state[i * 2] == BytePayload) {
+      len += snprintf(buff + len, sizeof(buff) - len, "%s\"%s\":%d", sep, id, state[i * 2 + 1]);
+    } else {
+      len += snprintf(buff + len, sizeof(buff) - len, "%s\"%s\":null", sep, id);
+    }
+  }
+  free(state);
+  len += snprintf(buff + len, sizeof(buff) - len, "}");
+  _http.sendContent(buff);
+}
+
+
+void RADConnector::handleLog(void) {
+  if(_http.method() != HTTP_GET) {
+    _http.send(405);
+    return;
+  }
+  // Records are formatted as they are streamed, oldest first
+  char buff[RAD_LOG_LINE + 1];
+  _http.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _http.send(200, "text/plain", "");
+  for(uint32_t seq = RADLog::getFirst(); seq < RADLog::getWritten(); seq++) {
+    if(RADLog::format(seq, buff, RAD_LOG_LINE)) {
+      strcat(buff, "\n");
+      _http.sendContent(buff);
+    }
   }
 }
 
 
+void RADConnector::handleNotFound(void) {
+  if(!admit()) {
+    return;
+  }
+  // Command status resources are the only dynamic paths, /commands/{id}
+  String uri = _http.uri();
+  if(uri.startsWith(RAD_COMMANDS_PATH "/")) {
+    const char* id = uri.c_str() + strlen(RAD_COMMANDS_PATH "/");
+    if(*id != '\0' && strlen(id) <= 5 && strspn(id, "0123456789") == strlen(id)) {
+      // Ids past the uint16_t range would otherwise wrap onto another command
+      unsigned long command_id = strtoul(id, NULL, 10);
+      if(command_id <= UINT16_MAX) {
+        handleCommandStatus(command_id);
+        return;
+      }
+    }
+  }
+  _http.send(404, "application/json", "{\"error\": \"Not found.\"}");
+}
+
+
 void RADConnector::handleEvents(RADFeature* feature) {
-  Serial.println("RADConnector::handleEvents");
+  RAD_DEBUG("RADConnector::handleEvents");
   _http.send(200, "application/json", "RADConnector::handleEvents");
   return;
 }
 
 
+void RADConnector::handleHistory(RADFeature* feature) {
+  RAD_DEBUG("RADConnector::handleHistory");
+  RADHistory* history = feature->getHistory();
+  if(_http.method() != HTTP_GET) {
+    _http.send(405);
+    return;
+  } else if(history == NULL) {
+    _http.send(404, "application/json", "{\"error\": \"History is not enabled for this feature.\"}");
+    return;
+  }
+
+  // Stream the response as
+  //   {"raw": [[age, value], ...], "minute": [[age, min, max, avg], ...]}
+  // with ages in seconds, oldest entries first
+  long current = millis();
+  char buff[256];
+  size_t len = 0;
+  bool first = true;
+  history->flush(current);
+  _http.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _http.send(200, "application/json", "");
+  len += snprintf(buff + len, sizeof(buff) - len, "{\"raw\":[");
+  for(int i = 0; i < history->getRawCount(); i++) {
+    long age = (current - history->getRawTime(i)) / 1000;
+    if(age >= (long)RAD_HISTORY_RAW_SIZE * RAD_HISTORY_RAW_PERIOD) continue;
+    len += snprintf(buff + len, sizeof(buff) - len, "%s[%ld,%d]",
+                    first ? "" : ",", age, history->getRawValue(i));
+    first = false;
+    if(len > sizeof(buff) - 32) {
+      _http.sendContent(buff);
+      len = 0;
+    }
+  }
+  len += snprintf(buff + len, sizeof(buff) - len, "],\"minute\":[");
+  for(int i = 0; i < history->getBucketCount(); i++) {
+    len += snprintf(buff + len, sizeof(buff) - len, "%s[%ld,%d,%d,%d]",
+                    i == 0 ? "" : ",", (current - history->getBucketTime(i)) / 1000,
+                    history->getBucketMin(i), history->getBucketMax(i), history->getBucketAvg(i));
+    if(len > sizeof(buff) - 32) {
+      _http.sendContent(buff);
+      len = 0;
+    }
+  }
+  len += snprintf(buff + len, sizeof(buff) - len, "]}");
+  _http.sendContent(buff);
+}
+
+
 bool RADConnector::execute(const char* feature_id, CommandType command_type, RADPayload* response) {
-  Serial.println("RADConnector::execute - empty");
+  RAD_DEBUG("RADConnector::execute - empty");
   return execute(feature_id, command_type, (RADPayload*)NULL, response);
 }
 
 
 bool RADConnector::execute(const char* feature_id, CommandType command_type, bool data, RADPayload* response) {
-  Serial.print("RADConnector::execute - bool = ");
-  Serial.println(data);
+  RAD_DEBUG("RADConnector::execute - bool = %d", data);
   RADPayload* payload = RADConnector::BuildPayload(data);
   bool result = execute(feature_id, command_type, payload, response);
+  free(payload->data);
   delete payload;
   return result;
 }
 
 
 bool RADConnector::execute(const char* feature_id, CommandType command_type, uint8_t data, RADPayload* response) {
-  Serial.println("RADConnector::execute - byte");
+  RAD_DEBUG("RADConnector::execute - byte");
   RADPayload* payload = RADConnector::BuildPayload(data);
   bool result = execute(feature_id, command_type, payload, response);
+  free(payload->data);
   delete payload;
   return result;
 }
 
 
 bool RADConnector::execute(const char* feature_id, CommandType command_type, RADPayload* payload, RADPayload* response) {
-  Serial.println("RADConnector::execute - payload");
+  RAD_DEBUG("RADConnector::execute - payload");
   RADFeature* feature;
   bool result = false;
   for(int i = 0; i < _features.size(); i++) {
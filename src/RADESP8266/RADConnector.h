@@ -8,10 +8,26 @@
 #include <FS.h>
 #include <LinkedList.h>
 #include "Types.h"
+#include "RADCommand.h"
 #include "RADFeature.h"
+#include "RADDeflate.h"
+#include "RADLimiter.h"
+#include "RADLog.h"
+#include "RADServer.h"
+#include "RADSocket.h"
 #include "RADSubscription.h"
 #include "Defines.h"
 
+#if RAD_MDNS
+#include <ESP8266mDNS.h>
+#endif
+
+#if RAD_ASYNC_SERVER
+typedef RADServer RADWebServer;
+#else
+typedef ESP8266WebServer RADWebServer;
+#endif
+
 static const char* _info_template =
   "{\r\n"
   "    \"name\": \"%s\",\r\n"
@@ -24,7 +40,11 @@ static const char* _info_template =
   "        \"features\": \"/features\",\r\n"
   "        \"commands\": \"/commands\",\r\n"
   "        \"events\": \"/events\",\r\n"
-  "        \"subscriptions\": \"/subscriptions\"\r\n"
+  "        \"subscriptions\": \"/subscriptions\",\r\n"
+  "        \"state\": \"/state\",\r\n"
+  "        \"stats\": \"/stats\",\r\n"
+  "        \"log\": \"/log\",\r\n"
+  "        \"api\": \"/api.json\"\r\n"
   "    }\r\n"
   "}\r\n"
   "\r\n";
@@ -41,12 +61,40 @@ class RADConnector
     LinkedList<RADSubscription*> _subscriptions;
     char _uuid[SSDP_UUID_SIZE];
     String _info;
-    ESP8266WebServer _http;
+    RADWebServer _http;
+#if RAD_WEBSOCKET
+    RADSocket _socket;
+#endif
 
 
     uint8_t _subscriptionCount;
     long _lastWrite;
     bool _subscriptionsChanged;
+    long _startupTime;
+
+    RADDeferredCommand _deferred[RAD_DEFERRED_COMMANDS];
+    uint16_t _deferredId;
+    bool _idle;
+    uint32_t _featuresHash;
+    uint32_t _apiHash;
+    char _apiFile[32];
+
+    // Subscription Snapshot Methods
+    int restore(void);
+
+    // Discovery Methods
+    uint32_t hashFeatures(void);
+    void advertise(void);
+    String describe(void);
+    void publish(void);
+
+    // Admission Control Methods
+    void on(const char* uri, std::function<void(void)> handler);
+    bool admit(void);
+
+    // Deferred Command Methods
+    RADDeferredCommand* defer(RADFeature* feature, CommandType command_type, PayloadType data_type, uint8_t data);
+    bool runDeferred(void);
 
     // HTTP Path Handler Functions
     void handleInfo(void);
@@ -55,6 +103,22 @@ class RADConnector
     void handleSubscriptions(RADFeature* feature);
     void handleCommands(RADFeature* feature);
     void handleEvents(RADFeature* feature);
+    void handleHistory(RADFeature* feature);
+    void handleCommandStatus(uint16_t command_id);
+    void handleStats(void);
+    void handleState(void);
+    void handleLog(void);
+    void handleApi(void);
+#if RAD_WEBSOCKET
+    void handleFrame(uint8_t client, bool binary, uint8_t* data, size_t len);
+    void handleEvent(RADFeature* feature, EventType event_type, bool has_value,
+                     uint8_t value, const char* body, size_t len);
+#endif
+
+    int dispatch(RADFeature* feature, RADCommand* command, RADPayload* response,
+                 uint16_t* command_id, char* message, size_t len);
+    int indexOf(RADFeature* feature);
+    void handleNotFound(void);
     // void handleSubscription(LinkedList<String>& segments);
 
     // Execution Methods
@@ -71,13 +135,20 @@ class RADConnector
     void add(RADFeature* feature);
 
     RADSubscription* subscribe(RADFeature* feature, EventType event_type,
-                               const char* callback, int timeout=RAD_MIN_TIMEOUT);
+                               const char* callback, int timeout=RAD_MIN_TIMEOUT,
+                               FilterType filter=NullFilter, uint8_t threshold=0,
+                               int interval=0);
     void unsubscribe(int index);
+    void limit(uint16_t client_rate, uint16_t client_burst,
+               uint16_t global_rate, uint16_t global_burst);
 
     bool begin(void);
     void update(void);
+    bool save(void);
+    long getStartupTime() { return _startupTime; };
 
     RADFeature* getFeature(const char* feature_id);
+    RADFeature* getFeature(const char* feature_id, size_t len);
 
     static RADPayload* BuildPayload(bool data);
     static RADPayload* BuildPayload(uint8_t data);
@@ -0,0 +1,171 @@
+#include "RADDeflate.h"
+
+
+// Fixed Huffman length and distance tables (RFC 1951 3.2.5)
+static const uint16_t LENGTH_BASE[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t LENGTH_EXTRA[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t DISTANCE_BASE[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t DISTANCE_EXTRA[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_HASH_SIZE (1 << RAD_DEFLATE_HASH_BITS)
+
+
+static uint16_t hash(const uint8_t* p) {
+  uint32_t h = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+  return (h * 2654435761u) >> (32 - RAD_DEFLATE_HASH_BITS);
+}
+
+
+RADDeflate::RADDeflate(Print& out) : _out(out) {
+  _len = 0;
+  _bits = 0;
+  _count = 0;
+  _written = 0;
+  _failed = false;
+}
+
+
+void RADDeflate::put(uint8_t c) {
+  _buff[_len++] = c;
+  if(_len == sizeof(_buff)) {
+    flush();
+  }
+}
+
+
+void RADDeflate::flush(void) {
+  if(_len > 0 && _out.write(_buff, _len) != _len) {
+    _failed = true;
+  }
+  _written += _len;
+  _len = 0;
+}
+
+
+void RADDeflate::bits(uint32_t value, uint8_t count) {
+  // Deflate packs bits starting at the least significant end of each byte
+  _bits |= value << _count;
+  _count += count;
+  while(_count >= 8) {
+    put(_bits & 0xff);
+    _bits >>= 8;
+    _count -= 8;
+  }
+}
+
+
+void RADDeflate::code(uint16_t code, uint8_t count) {
+  // Huffman codes are stored most significant bit first
+  uint16_t reversed = 0;
+  for(uint8_t i = 0; i < count; i++) {
+    reversed = (reversed << 1) | ((code >> i) & 1);
+  }
+  bits(reversed, count);
+}
+
+
+void RADDeflate::symbol(uint16_t sym) {
+  if(sym < 144) {
+    code(0x30 + sym, 8);
+  } else if(sym < 256) {
+    code(0x190 + sym - 144, 9);
+  } else if(sym < 280) {
+    code(sym - 256, 7);
+  } else {
+    code(0xc0 + sym - 280, 8);
+  }
+}
+
+
+void RADDeflate::match(uint16_t length, uint16_t distance) {
+  uint8_t i = 28;
+  while(LENGTH_BASE[i] > length) {
+    i--;
+  }
+  symbol(257 + i);
+  bits(length - LENGTH_BASE[i], LENGTH_EXTRA[i]);
+  i = 29;
+  while(DISTANCE_BASE[i] > distance) {
+    i--;
+  }
+  code(i, 5);
+  bits(distance - DISTANCE_BASE[i], DISTANCE_EXTRA[i]);
+}
+
+
+size_t RADDeflate::gzip(const uint8_t* data, size_t len, Print& out) {
+  // Slots hold position + 1 so zero means empty, inputs past 64 KB are
+  // still valid output but only coded as literals
+  uint16_t* head = (uint16_t*)calloc(DEFLATE_HASH_SIZE, sizeof(uint16_t));
+  if(head == NULL) {
+    return 0;
+  }
+  RADDeflate deflate(out);
+  static const uint8_t header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+  for(size_t i = 0; i < sizeof(header); i++) {
+    deflate.put(header[i]);
+  }
+
+  // A single final block using the fixed codes
+  deflate.bits(1, 1);
+  deflate.bits(1, 2);
+  size_t pos = 0;
+  while(pos < len) {
+    size_t best = 0;
+    size_t distance = 0;
+    if(pos + DEFLATE_MIN_MATCH <= len && pos < 0xffff) {
+      uint16_t h = hash(data + pos);
+      size_t candidate = head[h];
+      head[h] = pos + 1;
+      if(candidate > 0 && pos - (candidate - 1) <= RAD_DEFLATE_WINDOW) {
+        const uint8_t* p = data + candidate - 1;
+        size_t limit = len - pos < DEFLATE_MAX_MATCH ? len - pos : DEFLATE_MAX_MATCH;
+        while(best < limit && p[best] == data[pos + best]) {
+          best++;
+        }
+        distance = pos - (candidate - 1);
+      }
+    }
+    if(best >= DEFLATE_MIN_MATCH) {
+      deflate.match(best, distance);
+      // Index the positions inside the match so later data can refer to them
+      for(size_t i = pos + 1; i < pos + best && i + DEFLATE_MIN_MATCH <= len && i < 0xffff; i++) {
+        head[hash(data + i)] = i + 1;
+      }
+      pos += best;
+    } else {
+      deflate.symbol(data[pos]);
+      pos++;
+    }
+  }
+  deflate.symbol(256);
+  if(deflate._count > 0) {
+    deflate.bits(0, 8 - deflate._count);
+  }
+  free(head);
+
+  // Trailer is the CRC-32 and length of the uncompressed data
+  uint32_t crc = crc32(0, data, len);
+  for(uint8_t i = 0; i < 4; i++) {
+    deflate.put(crc >> (i * 8));
+  }
+  for(uint8_t i = 0; i < 4; i++) {
+    deflate.put(len >> (i * 8));
+  }
+  deflate.flush();
+  return deflate._failed ? 0 : deflate._written;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Defines.h"
+#include "Types.h"
+
+// Minimal gzip writer for documents generated on the device. The input is
+// held in memory, matched greedily against one hash slot per position and
+// coded with the fixed Huffman table, so there is no tree to build and the
+// only working memory is the hash table. That is a worse ratio than zlib but
+// still shrinks repetitive JSON to a fraction of its size.
+class RADDeflate {
+
+  private:
+
+    Print& _out;
+    uint8_t _buff[RAD_DEFLATE_BUFFER];
+    size_t _len;
+    uint32_t _bits;
+    uint8_t _count;
+    size_t _written;
+    bool _failed;
+
+    RADDeflate(Print& out);
+
+    void put(uint8_t c);
+    void flush(void);
+    void bits(uint32_t value, uint8_t count);
+    void code(uint16_t code, uint8_t count);
+    void symbol(uint16_t sym);
+    void match(uint16_t length, uint16_t distance);
+
+  public:
+
+    // Writes data to out as a gzip member and returns the compressed size,
+    // or 0 when the hash table can't be allocated or out stops accepting bytes
+    static size_t gzip(const uint8_t* data, size_t len, Print& out);
+};
@@ -2,6 +2,50 @@
 #include "RADFeature.h"
 
 
+// Event body templates, the head for each event type is fixed at compile
+// time so a body is rendered by copying it and appending the data
+static const char* const EVENT_HEADS[] = {
+  "{\"event_type\":\"NullEvent\"",
+  "{\"event_type\":\"All\"",
+  "{\"event_type\":\"Start\"",
+  "{\"event_type\":\"State\"",
+  "{\"event_type\":\"Complete\""
+};
+
+
+static size_t appendEvent(char* buff, size_t len, size_t size, const char* s) {
+  while(*s && len + 1 < size) {
+    buff[len++] = *s++;
+  }
+  buff[len] = 0;
+  return len;
+}
+
+
+static size_t appendEvent(char* buff, size_t len, size_t size, unsigned int value) {
+  char digits[6];
+  int i = sizeof(digits) - 1;
+  digits[i] = 0;
+  do {
+    digits[--i] = '0' + value % 10;
+    value /= 10;
+  } while(value > 0 && i > 0);
+  return appendEvent(buff, len, size, &digits[i]);
+}
+
+
+static size_t renderEvent(char* buff, size_t size, EventType event_type) {
+  if(event_type > Complete) {
+    event_type = NullEvent;
+  }
+  return appendEvent(buff, 0, size, EVENT_HEADS[event_type]);
+}
+
+
+char RADFeature::_event[RAD_EVENT_SIZE];
+RADFeature::TEventFunction RADFeature::_listener;
+
+
 RADFeature::RADFeature(FeatureType type, const char* id, const char* name) {
   _type = type;
   _id = id;
@@ -15,13 +59,103 @@ RADFeature::RADFeature(FeatureType type, const char* id, const char* name) {
   _setByteCb = NULL;
   _setByteArrayCb = NULL;
   _triggerCb = NULL;
+  _sampler = NULL;
+  _history = NULL;
+  _stateKnown = false;
+  _stateType = NullPayload;
+  _stateValue = 0;
+  _stateTime = 0;
+  _cacheTtl = 0;
+  _refresh = false;
+  _deferred = false;
+}
+
+
+void RADFeature::history(void) {
+  if(_history == NULL) {
+    _history = new RADHistory();
+  }
+}
+
+
+void RADFeature::cache(unsigned long freshness) {
+  _cacheTtl = freshness;
+}
+
+
+void RADFeature::record(PayloadType type, uint8_t value) {
+  _stateKnown = true;
+  _stateType = type;
+  _stateValue = value;
+  _stateTime = millis();
+  if(_history != NULL) {
+    _history->record(_stateTime, value);
+  }
+}
+
+
+bool RADFeature::fetch(GetFp get, RADPayload* response) {
+  RADPayload* getResponse = get();
+  if(getResponse == NULL) {
+    return false;
+  }
+  if(getResponse->type != ByteArrayPayload && getResponse->len == 1) {
+    // Single byte payloads are copied into the last known state
+    record(getResponse->type, getResponse->data[0]);
+    free(getResponse->data);
+    if(response != NULL) {
+      response->type = _stateType;
+      response->len = 1;
+      response->data = &_stateValue;
+    }
+  } else if(response != NULL) {
+    response->type = getResponse->type;
+    response->len = getResponse->len;
+    response->data = getResponse->data;
+  } else {
+    // Nobody to hand the byte array to
+    free(getResponse->data);
+  }
+  delete getResponse;
+  return true;
+}
+
+
+void RADFeature::sample(ReadBoolFp func, unsigned long interval, unsigned long debounce) {
+  delete _sampler;
+  _sampler = new RADSampler(func, interval, debounce);
+}
+
+
+void RADFeature::sample(ReadByteFp func, unsigned long interval, uint8_t deadband,
+                        uint8_t hysteresis, unsigned long debounce) {
+  delete _sampler;
+  _sampler = new RADSampler(func, interval, deadband, hysteresis, debounce);
+}
+
+
+void RADFeature::poll(long current) {
+  // Refresh a stale cached state outside of the request
+  if(_refresh) {
+    _refresh = false;
+    if(_getCb != NULL) {
+      fetch(_getCb, NULL);
+    }
+  }
+  if(_sampler == NULL || !_sampler->sample(current)) {
+    return;
+  }
+  if(_sampler->getPayloadType() == BoolPayload) {
+    send(State, _sampler->getValue() != 0);
+  } else {
+    send(State, _sampler->getValue());
+  }
 }
 
 
 bool RADFeature::execute(CommandType command_type, RADPayload* payload, RADPayload* response) {
-  Serial.println("RADFeature::execute");
+  RAD_DEBUG("RADFeature::execute");
   bool result = false;
-  RADPayload* getResponse;
   TriggerFp trigger = NULL;
   SetBoolFp setBool = NULL;
   SetByteFp setByte = NULL;
@@ -39,19 +173,31 @@ bool RADFeature::execute(CommandType command_type, RADPayload* payload, RADPaylo
       }
       break;
     case Set:
-      Serial.println("RADFeature::execute - case Set:");
+      RAD_DEBUG("RADFeature::execute - case Set:");
       switch(_type) {
         case SwitchBinary:
           setBool = _setBoolCb;
           break;
+        case SwitchMultiLevel:
+          setByte = _setByteCb;
+          break;
       }
       if(setBool != NULL) {
-        Serial.println("RADFeature::execute - setBool");
+        RAD_DEBUG("RADFeature::execute - setBool");
         if(payload != NULL && payload->type == BoolPayload && payload->len == 1) {
           result = setBool((bool)payload->data[0]);
+          if(result) {
+            record(payload->type, payload->data[0]);
+          }
         }
       } else if(setByte != NULL) {
-        result = false;
+        RAD_DEBUG("RADFeature::execute - setByte");
+        if(payload != NULL && payload->type == BytePayload && payload->len == 1) {
+          result = setByte(payload->data[0]);
+          if(result) {
+            record(payload->type, payload->data[0]);
+          }
+        }
       } else if(setByteArray != NULL) {
         result = false;
       }
@@ -59,18 +205,26 @@ bool RADFeature::execute(CommandType command_type, RADPayload* payload, RADPaylo
     case Get:
       switch(_type) {
         case SwitchBinary:
+        case SensorBinary:
+        case SwitchMultiLevel:
+        case SensorMultiLevel:
           get = _getCb;
           break;
       }
-      if(get != NULL) {
-        getResponse = get();
+      if(_stateKnown && (get == NULL || _cacheTtl > 0)) {
+        // Serve from the last known state and refresh it from poll() once
+        // it is older than the cache freshness bound
+        if(get != NULL && (unsigned long)(millis() - _stateTime) >= _cacheTtl) {
+          _refresh = true;
+        }
         result = true;
         if(response != NULL) {
-          response->type = getResponse->type;
-          response->len = getResponse->len;
-          response->data = getResponse->data;
+          response->type = _stateType;
+          response->len = 1;
+          response->data = &_stateValue;
         }
-        delete getResponse;
+      } else if(get != NULL) {
+        result = fetch(get, response);
       }
       break;
   }
@@ -78,29 +232,63 @@ bool RADFeature::execute(CommandType command_type, RADPayload* payload, RADPaylo
 }
 
 
+// Mirrors the callbacks execute() dispatches to for each feature type
+bool RADFeature::supports(CommandType command_type) {
+  switch(command_type) {
+    case Trigger:
+      return _type == TriggerFeature && _triggerCb != NULL;
+    case Set:
+      return (_type == SwitchBinary && _setBoolCb != NULL) ||
+             (_type == SwitchMultiLevel && _setByteCb != NULL);
+    case Get:
+      return _type == SwitchBinary || _type == SensorBinary ||
+             _type == SwitchMultiLevel || _type == SensorMultiLevel;
+    default:
+      return false;
+  }
+}
+
+
+PayloadType RADFeature::getPayloadType(void) {
+  switch(_type) {
+    case SwitchBinary:
+    case SensorBinary:
+      return BoolPayload;
+    case SwitchMultiLevel:
+    case SensorMultiLevel:
+      return BytePayload;
+    default:
+      return NullPayload;
+  }
+}
+
+
 void RADFeature::send(EventType event_type) {
-  StaticJsonBuffer<1024> json_buffer;
-  JsonObject& json_body = json_buffer.createObject();
-  json_body["event_type"] = sendEventType(event_type);
-  sendEvent(event_type, json_body);
+  size_t len = renderEvent(_event, sizeof(_event), event_type);
+  len = appendEvent(_event, len, sizeof(_event), "}");
+  sendEvent(event_type, len);
 }
 
 
 void RADFeature::send(EventType event_type, bool data) {
-  StaticJsonBuffer<1024> json_buffer;
-  JsonObject& json_body = json_buffer.createObject();
-  json_body["event_type"] = sendEventType(event_type);
-  json_body["data"] = data;
-  sendEvent(event_type, json_body);
+  size_t len = renderEvent(_event, sizeof(_event), event_type);
+  len = appendEvent(_event, len, sizeof(_event), data ? ",\"data\":true}" : ",\"data\":false}");
+  if(event_type == State) {
+    record(BoolPayload, data ? 255 : 0);
+  }
+  sendEvent(event_type, len, true, data ? 255 : 0);
 }
 
 
 void RADFeature::send(EventType event_type, uint8_t data) {
-  StaticJsonBuffer<1024> json_buffer;
-  JsonObject& json_body = json_buffer.createObject();
-  json_body["event_type"] = sendEventType(event_type);
-  json_body["data"] = data;
-  sendEvent(event_type, json_body);
+  size_t len = renderEvent(_event, sizeof(_event), event_type);
+  len = appendEvent(_event, len, sizeof(_event), ",\"data\":");
+  len = appendEvent(_event, len, sizeof(_event), data);
+  len = appendEvent(_event, len, sizeof(_event), "}");
+  if(event_type == State) {
+    record(BytePayload, data);
+  }
+  sendEvent(event_type, len, true, data);
 }
 
 
@@ -109,30 +297,117 @@ void RADFeature::send(EventType event_type, uint8_t* data, uint8_t len) {
 }
 
 
-void RADFeature::sendEvent(EventType event_type, JsonObject& json_body) {
+void RADFeature::complete(uint16_t command_id, CommandType command_type, bool result) {
+  size_t len = renderEvent(_event, sizeof(_event), Complete);
+  len = appendEvent(_event, len, sizeof(_event), ",\"command_id\":");
+  len = appendEvent(_event, len, sizeof(_event), command_id);
+  len = appendEvent(_event, len, sizeof(_event), ",\"command_type\":\"");
+  len = appendEvent(_event, len, sizeof(_event), sendCommandType(command_type));
+  len = appendEvent(_event, len, sizeof(_event), result ? "\",\"result\":true}" : "\",\"result\":false}");
+  sendEvent(Complete, len);
+}
+
+
+bool RADFeature::sendEvent(EventType event_type, JsonObject& json_body,
+                           bool has_value, uint8_t value) {
+  size_t len = json_body.measureLength();
+  if(len < sizeof(_event)) {
+    json_body.printTo(_event, sizeof(_event));
+    sendEvent(event_type, len, has_value, value);
+    return true;
+  }
+  // Custom bodies larger than the shared buffer get one of their own
+  if(len >= RAD_CUSTOM_EVENT_SIZE) {
+    RAD_WARN("RADFeature::sendEvent - %s event of %u bytes dropped", _id, len);
+    return false;
+  }
+  char* body = (char*)malloc(len + 1);
+  if(body == NULL) {
+    RAD_WARN("RADFeature::sendEvent - no memory for a %u byte %s event", len, _id);
+    return false;
+  }
+  json_body.printTo(body, len + 1);
+  deliver(event_type, body, len, has_value, value);
+  free(body);
+  return true;
+}
+
+
+// Sends the body already rendered into _event
+void RADFeature::sendEvent(EventType event_type, size_t len,
+                           bool has_value, uint8_t value) {
+  deliver(event_type, _event, len, has_value, value);
+}
+
+
+// The same bytes go to the listener and every subscriber
+void RADFeature::deliver(EventType event_type, const char* body, size_t len,
+                         bool has_value, uint8_t value) {
   RADSubscription* s;
-  char body[1024];
-  json_body.printTo(body, sizeof(body));
+  long current;
+  if(_listener) {
+    _listener(this, event_type, has_value, value, body, len);
+  }
   for(int i = 0; i < _subscriptions.size(); i++) {
     s = _subscriptions.get(i);
-    if(s->getType() == event_type) {
-      HTTPClient http;
-      http.begin(s->getCallback());
-      http.addHeader("SID", s->getSid());
-      http.addHeader("RAD-ID", _id);
-      http.addHeader("RAD-EVENT", sendEventType(event_type));
-      http.addHeader("Content-Type", "application/json");
-      int httpCode = http.sendRequest("NOTIFY", body);
-      if(httpCode > 0) {
-        if(httpCode == HTTP_CODE_OK) {
-            String response = http.getString();
-        }
-      } else {
-        Serial.printf("[HTTP] GET... failed, error: %s\n", http.errorToString(httpCode).c_str());
-      }
-      http.end();
+    current = millis();
+    if(s->isActive(current) && s->accepts(event_type, has_value, value, current)) {
+      notify(s, event_type, body, len, has_value, value);
+    }
+  }
+}
+
+
+// Sends the value a subscription's interval held back, to that subscriber only
+void RADFeature::resend(RADSubscription* subscription) {
+  EventType event_type = subscription->getPendingType();
+  uint8_t value = subscription->getPendingValue();
+  size_t len = renderEvent(_event, sizeof(_event), event_type);
+  if(getPayloadType() == BoolPayload) {
+    len = appendEvent(_event, len, sizeof(_event), value ? ",\"data\":true}" : ",\"data\":false}");
+  } else {
+    len = appendEvent(_event, len, sizeof(_event), ",\"data\":");
+    len = appendEvent(_event, len, sizeof(_event), value);
+    len = appendEvent(_event, len, sizeof(_event), "}");
+  }
+  notify(subscription, event_type, _event, len, true, value);
+}
+
+
+void RADFeature::notify(RADSubscription* s, EventType event_type, const char* body, size_t len,
+                        bool has_value, uint8_t value) {
+  long current = millis();
+  // Skip hosts that are known to be down instead of waiting on a timeout
+  RADCircuit* circuit = RADCircuit::get(s->getCallback(), current);
+  if(circuit != NULL && !circuit->allow(current)) {
+    return;
+  }
+  s->notified(has_value, value, current);
+  HTTPClient http;
+  http.setTimeout(RAD_NOTIFY_TIMEOUT);
+  http.begin(s->getCallback());
+  http.addHeader("SID", s->getSid());
+  http.addHeader("RAD-ID", _id);
+  http.addHeader("RAD-EVENT", sendEventType(event_type));
+  http.addHeader("Content-Type", "application/json");
+  int httpCode = http.sendRequest("NOTIFY", (uint8_t*)body, len);
+  current = millis();
+  if(httpCode > 0) {
+    s->success();
+    if(circuit != NULL) {
+      circuit->success(current);
+    }
+    if(httpCode == HTTP_CODE_OK) {
+        String response = http.getString();
+    }
+  } else {
+    s->failure();
+    if(circuit != NULL) {
+      circuit->failure(current);
     }
+    RAD_WARN("RADFeature::sendEvent - NOTIFY for %s failed, error: %d", _id, httpCode);
   }
+  http.end();
 }
 
 
@@ -8,13 +8,24 @@
 #include <ESP8266HTTPClient.h>
 #include <ESP8266WiFi.h>
 #include <LinkedList.h>
+#include <functional>
 #include "Defines.h"
 #include "Types.h"
+#include "RADCircuit.h"
+#include "RADHistory.h"
+#include "RADLog.h"
+#include "RADSampler.h"
 #include "RADSubscription.h"
 
 
 class RADFeature {
 
+  public:
+
+    // Called with every rendered event before it goes to the subscriptions
+    typedef std::function<void(RADFeature* feature, EventType event_type, bool has_value,
+                               uint8_t value, const char* body, size_t len)> TEventFunction;
+
   private:
 
     FeatureType _type;
@@ -27,8 +38,30 @@ class RADFeature {
     SetByteArrayFp    _setByteArrayCb;
     TriggerFp         _triggerCb;
 
+    RADSampler* _sampler;
+    RADHistory* _history;
+
+    // Last known state
+    bool _stateKnown;
+    PayloadType _stateType;
+    uint8_t _stateValue;
+    long _stateTime;
+    unsigned long _cacheTtl;
+    bool _refresh;
+    bool _deferred;
+
+    static char _event[RAD_EVENT_SIZE];
+    static TEventFunction _listener;
+
     LinkedList<RADSubscription*> _subscriptions;
 
+    void record(PayloadType type, uint8_t value);
+    bool fetch(GetFp get, RADPayload* response);
+    void deliver(EventType event_type, const char* body, size_t len,
+                 bool has_value, uint8_t value);
+    void notify(RADSubscription* subscription, EventType event_type, const char* body,
+                size_t len, bool has_value, uint8_t value);
+
   public:
 
     RADFeature(FeatureType type, const char* id, const char* name=NULL);
@@ -36,6 +69,8 @@ class RADFeature {
     FeatureType getType() { return _type; };
     const char* getId() { return _id; };
     const char* getName() { return _name; };
+    RADHistory* getHistory() { return _history; };
+    bool isDeferred() { return _deferred; };
 
     void callback(CommandType command_type, GetFp func) { _getCb = func; };
     void callback(CommandType command_type, SetBoolFp func) { _setBoolCb = func; };
@@ -43,13 +78,34 @@ class RADFeature {
     void callback(CommandType command_type, SetByteArrayFp func) { _setByteArrayCb = func; };
     void callback(CommandType command_type, TriggerFp func) { _triggerCb = func; };
 
+    void sample(ReadBoolFp func, unsigned long interval=RAD_SAMPLE_INTERVAL,
+                unsigned long debounce=0);
+    void sample(ReadByteFp func, unsigned long interval=RAD_SAMPLE_INTERVAL,
+                uint8_t deadband=0, uint8_t hysteresis=0, unsigned long debounce=0);
+    void poll(long current);
+    void history(void);
+    void cache(unsigned long freshness);
+    void deferred(bool enabled=true) { _deferred = enabled; };
+
     bool execute(CommandType command_type, RADPayload* payload, RADPayload* response);
+    bool supports(CommandType command_type);
+    PayloadType getPayloadType(void);
 
     void send(EventType event_type);
     void send(EventType event_type, bool data);
     void send(EventType event_type, uint8_t data);
     void send(EventType event_type, uint8_t* data, uint8_t len);
-    void sendEvent(EventType event_type, JsonObject& json_body);
+    void complete(uint16_t command_id, CommandType command_type, bool result);
+    // Returns false when the body is RAD_CUSTOM_EVENT_SIZE or more and was
+    // dropped
+    bool sendEvent(EventType event_type, JsonObject& json_body,
+                   bool has_value=false, uint8_t value=0);
+    void sendEvent(EventType event_type, size_t len,
+                   bool has_value=false, uint8_t value=0);
+
+    static void listen(TEventFunction listener) { _listener = listener; };
+
+    void resend(RADSubscription* subscription);
 
     void add(RADSubscription* subscription);
     void remove(RADSubscription* subscription);
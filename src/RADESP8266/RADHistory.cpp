@@ -0,0 +1,96 @@
+#include "RADHistory.h"
+
+
+RADHistory::RADHistory() {
+  _rawStart = 0;
+  _rawCount = 0;
+  _bucketStart = 0;
+  _bucketCount = 0;
+  _started = false;
+  _currentTime = 0;
+  _currentMin = 0;
+  _currentMax = 0;
+  _currentSum = 0;
+  _currentCount = 0;
+  _last = 0;
+}
+
+
+void RADHistory::record(long current, uint8_t value) {
+  flush(current);
+
+  // Raw samples, the last value seen within a raw period wins
+  uint8_t last = (_rawStart + _rawCount + RAD_HISTORY_RAW_SIZE - 1) % RAD_HISTORY_RAW_SIZE;
+  if(_rawCount > 0 && current - _rawTime[last] < RAD_HISTORY_RAW_PERIOD * 1000L) {
+    _rawValue[last] = value;
+  } else {
+    uint8_t next = (_rawStart + _rawCount) % RAD_HISTORY_RAW_SIZE;
+    if(_rawCount < RAD_HISTORY_RAW_SIZE) {
+      _rawCount += 1;
+    } else {
+      _rawStart = (_rawStart + 1) % RAD_HISTORY_RAW_SIZE;
+    }
+    _rawTime[next] = current;
+    _rawValue[next] = value;
+  }
+
+  // Aggregate bucket
+  if(!_started) {
+    begin(current, value);
+    _started = true;
+  } else {
+    if(value < _currentMin) _currentMin = value;
+    if(value > _currentMax) _currentMax = value;
+    _currentSum += value;
+    _currentCount += 1;
+  }
+  _last = value;
+}
+
+
+void RADHistory::flush(long current) {
+  if(!_started) {
+    return;
+  }
+  long period = RAD_HISTORY_BUCKET_PERIOD * 1000L;
+  if(current - _currentTime < period) {
+    return;
+  }
+  push(_currentTime, _currentMin, _currentMax, _currentSum / _currentCount);
+  _currentTime += period;
+
+  // Periods without any records held the last value the whole time
+  long skipped = (current - _currentTime) / period;
+  if(skipped > RAD_HISTORY_BUCKET_SIZE) {
+    _currentTime += (skipped - RAD_HISTORY_BUCKET_SIZE) * period;
+    skipped = RAD_HISTORY_BUCKET_SIZE;
+  }
+  for(long i = 0; i < skipped; i++) {
+    push(_currentTime, _last, _last, _last);
+    _currentTime += period;
+  }
+  begin(_currentTime, _last);
+}
+
+
+void RADHistory::begin(long time, uint8_t value) {
+  _currentTime = time;
+  _currentMin = value;
+  _currentMax = value;
+  _currentSum = value;
+  _currentCount = 1;
+}
+
+
+void RADHistory::push(long time, uint8_t min, uint8_t max, uint8_t avg) {
+  uint8_t next = (_bucketStart + _bucketCount) % RAD_HISTORY_BUCKET_SIZE;
+  if(_bucketCount < RAD_HISTORY_BUCKET_SIZE) {
+    _bucketCount += 1;
+  } else {
+    _bucketStart = (_bucketStart + 1) % RAD_HISTORY_BUCKET_SIZE;
+  }
+  _bucketTime[next] = time;
+  _bucketMin[next] = min;
+  _bucketMax[next] = max;
+  _bucketAvg[next] = avg;
+}
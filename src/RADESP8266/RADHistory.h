@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Defines.h"
+#include "Types.h"
+
+// Fixed memory time-series store for a single feature value. Recent values
+// are kept at RAD_HISTORY_RAW_PERIOD second resolution and are folded into
+// min/max/avg buckets of RAD_HISTORY_BUCKET_PERIOD seconds each as they age.
+class RADHistory {
+
+  private:
+
+    // Raw samples, at most one per raw period
+    long _rawTime[RAD_HISTORY_RAW_SIZE];
+    uint8_t _rawValue[RAD_HISTORY_RAW_SIZE];
+    uint8_t _rawStart;
+    uint8_t _rawCount;
+
+    // Completed aggregate buckets
+    long _bucketTime[RAD_HISTORY_BUCKET_SIZE];
+    uint8_t _bucketMin[RAD_HISTORY_BUCKET_SIZE];
+    uint8_t _bucketMax[RAD_HISTORY_BUCKET_SIZE];
+    uint8_t _bucketAvg[RAD_HISTORY_BUCKET_SIZE];
+    uint8_t _bucketStart;
+    uint8_t _bucketCount;
+
+    // Bucket currently being accumulated
+    bool _started;
+    long _currentTime;
+    uint8_t _currentMin;
+    uint8_t _currentMax;
+    uint32_t _currentSum;
+    uint16_t _currentCount;
+    uint8_t _last;
+
+    void push(long time, uint8_t min, uint8_t max, uint8_t avg);
+    void begin(long time, uint8_t value);
+
+  public:
+
+    RADHistory();
+
+    void record(long current, uint8_t value);
+    void flush(long current);
+
+    uint8_t getRawCount() { return _rawCount; };
+    long getRawTime(uint8_t i) { return _rawTime[(_rawStart + i) % RAD_HISTORY_RAW_SIZE]; };
+    uint8_t getRawValue(uint8_t i) { return _rawValue[(_rawStart + i) % RAD_HISTORY_RAW_SIZE]; };
+
+    uint8_t getBucketCount() { return _bucketCount; };
+    long getBucketTime(uint8_t i) { return _bucketTime[(_bucketStart + i) % RAD_HISTORY_BUCKET_SIZE]; };
+    uint8_t getBucketMin(uint8_t i) { return _bucketMin[(_bucketStart + i) % RAD_HISTORY_BUCKET_SIZE]; };
+    uint8_t getBucketMax(uint8_t i) { return _bucketMax[(_bucketStart + i) % RAD_HISTORY_BUCKET_SIZE]; };
+    uint8_t getBucketAvg(uint8_t i) { return _bucketAvg[(_bucketStart + i) % RAD_HISTORY_BUCKET_SIZE]; };
+};
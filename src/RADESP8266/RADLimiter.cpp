@@ -0,0 +1,117 @@
+#include "RADLimiter.h"
+
+
+RADLimiter RADLimiter::_clients[RAD_LIMIT_CLIENTS];
+RADLimiter RADLimiter::_global;
+uint16_t RADLimiter::_clientRate = RAD_LIMIT_CLIENT_RATE;
+uint16_t RADLimiter::_clientBurst = RAD_LIMIT_CLIENT_BURST;
+uint16_t RADLimiter::_globalRate = RAD_LIMIT_GLOBAL_RATE;
+uint16_t RADLimiter::_globalBurst = RAD_LIMIT_GLOBAL_BURST;
+uint32_t RADLimiter::_admitted = 0;
+uint32_t RADLimiter::_rejectedClient = 0;
+uint32_t RADLimiter::_rejectedGlobal = 0;
+
+
+RADLimiter::RADLimiter() {
+  _ip = 0;
+  _tokens = -1;
+  _updated = 0;
+}
+
+
+void RADLimiter::refill(long current, uint16_t rate, uint16_t burst) {
+  // A new bucket starts full
+  long capacity = (long)burst * 1000;
+  if(_tokens < 0) {
+    _tokens = capacity;
+  } else {
+    long elapsed = current - _updated;
+    if(elapsed > 0) {
+      // An empty bucket is full again after this long, capping the elapsed
+      // time also keeps the multiplication from overflowing
+      if(elapsed > capacity / rate + 1) {
+        elapsed = capacity / rate + 1;
+      }
+      _tokens += elapsed * rate;
+    }
+    if(_tokens > capacity) {
+      _tokens = capacity;
+    }
+  }
+  _updated = current;
+}
+
+
+long RADLimiter::wait(uint16_t rate) {
+  // Whole seconds until the bucket holds a token again, rounded up
+  long missing = 1000 - _tokens;
+  return (missing + (long)rate * 1000 - 1) / ((long)rate * 1000);
+}
+
+
+void RADLimiter::configure(uint16_t client_rate, uint16_t client_burst,
+                           uint16_t global_rate, uint16_t global_burst) {
+  _clientRate = client_rate;
+  _clientBurst = client_burst > 0 ? client_burst : 1;
+  _globalRate = global_rate;
+  _globalBurst = global_burst > 0 ? global_burst : 1;
+  for(int i = 0; i < RAD_LIMIT_CLIENTS; i++) {
+    _clients[i] = RADLimiter();
+  }
+  _global = RADLimiter();
+}
+
+
+bool RADLimiter::admit(uint32_t ip, long current, int* retry) {
+  RADLimiter* client = NULL;
+  if(_clientRate > 0) {
+    RADLimiter* candidate = NULL;
+    for(int i = 0; i < RAD_LIMIT_CLIENTS; i++) {
+      if(_clients[i]._tokens >= 0 && _clients[i]._ip == ip) {
+        client = &_clients[i];
+        break;
+      }
+      // Prefer empty slots, then the least recently seen client
+      if(candidate == NULL || (candidate->_tokens >= 0 &&
+         (_clients[i]._tokens < 0 || _clients[i]._updated - candidate->_updated < 0))) {
+        candidate = &_clients[i];
+      }
+    }
+    if(client == NULL) {
+      client = candidate;
+      *client = RADLimiter();
+      client->_ip = ip;
+    }
+    client->refill(current, _clientRate, _clientBurst);
+    if(client->_tokens < 1000) {
+      _rejectedClient += 1;
+      *retry = client->wait(_clientRate);
+      return false;
+    }
+  }
+  if(_globalRate > 0) {
+    _global.refill(current, _globalRate, _globalBurst);
+    if(_global._tokens < 1000) {
+      _rejectedGlobal += 1;
+      *retry = _global.wait(_globalRate);
+      return false;
+    }
+    _global._tokens -= 1000;
+  }
+  if(client != NULL) {
+    client->_tokens -= 1000;
+  }
+  _admitted += 1;
+  return true;
+}
+
+
+uint8_t RADLimiter::getClients() {
+  uint8_t count = 0;
+  for(int i = 0; i < RAD_LIMIT_CLIENTS; i++) {
+    if(_clients[i]._tokens >= 0) {
+      count += 1;
+    }
+  }
+  return count;
+}
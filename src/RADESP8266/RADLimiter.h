@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Defines.h"
+#include "Types.h"
+
+// Token bucket admission control for inbound requests. Every client IP gets
+// its own bucket, tracked in a small table with least recently used eviction,
+// and all requests also draw from a single global bucket. A request is only
+// admitted when both buckets hold a token, so a busy client can not starve
+// the others and the whole device never handles more than the global rate.
+class RADLimiter {
+
+  private:
+
+    uint32_t _ip;
+    long _tokens;   // thousandths of a token
+    long _updated;
+
+    void refill(long current, uint16_t rate, uint16_t burst);
+    long wait(uint16_t rate);
+
+    static RADLimiter _clients[RAD_LIMIT_CLIENTS];
+    static RADLimiter _global;
+    static uint16_t _clientRate;
+    static uint16_t _clientBurst;
+    static uint16_t _globalRate;
+    static uint16_t _globalBurst;
+    static uint32_t _admitted;
+    static uint32_t _rejectedClient;
+    static uint32_t _rejectedGlobal;
+
+  public:
+
+    RADLimiter();
+
+    // Rates are in requests per second, a rate of 0 disables that bucket
+    static void configure(uint16_t client_rate, uint16_t client_burst,
+                          uint16_t global_rate, uint16_t global_burst);
+
+    // Returns true when the request may be handled, otherwise retry is set to
+    // the number of seconds until a token becomes available
+    static bool admit(uint32_t ip, long current, int* retry);
+
+    static uint32_t getAdmitted() { return _admitted; };
+    static uint32_t getRejectedClient() { return _rejectedClient; };
+    static uint32_t getRejectedGlobal() { return _rejectedGlobal; };
+    static uint8_t getClients();
+
+};
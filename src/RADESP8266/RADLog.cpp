@@ -0,0 +1,70 @@
+#include "RADLog.h"
+
+
+RADLogRecord RADLog::_records[RAD_LOG_SIZE];
+uint32_t RADLog::_written = 0;
+uint32_t RADLog::_drained = 0;
+
+
+void RADLog::write(uint8_t level, const char* format, const uintptr_t* args, uint8_t count) {
+  RADLogRecord* record = &_records[_written % RAD_LOG_SIZE];
+  record->time = millis();
+  record->format = format;
+  record->level = level;
+  for(uint8_t i = 0; i < RAD_LOG_ARGS; i++) {
+    record->args[i] = i < count ? args[i] : 0;
+  }
+  _written += 1;
+}
+
+
+uint32_t RADLog::getFirst() {
+  return _written > RAD_LOG_SIZE ? _written - RAD_LOG_SIZE : 0;
+}
+
+
+bool RADLog::format(uint32_t seq, char* buff, size_t len) {
+  if(seq < getFirst() || seq >= _written) {
+    return false;
+  }
+  RADLogRecord* record = &_records[seq % RAD_LOG_SIZE];
+  int n = snprintf(buff, len, "[%lu] %s ", record->time, sendLevel(record->level));
+  if(n < 0 || (size_t)n >= len) {
+    return true;
+  }
+  snprintf(buff + n, len - n, record->format, record->args[0], record->args[1], record->args[2]);
+  return true;
+}
+
+
+void RADLog::drain(HardwareSerial& out, uint8_t max) {
+  char buff[RAD_LOG_LINE];
+  if(_drained < getFirst()) {
+    _drained = getFirst();
+  }
+  while(max > 0 && _drained < _written) {
+    // Leave the record for a later call rather than block on the UART
+    if(out.availableForWrite() < RAD_LOG_LINE) {
+      break;
+    }
+    format(_drained, buff, sizeof(buff));
+    out.println(buff);
+    _drained += 1;
+    max -= 1;
+  }
+}
+
+
+const char* RADLog::sendLevel(uint8_t level) {
+  const char* s = "NONE";
+  if(level == RAD_LOG_ERROR) {
+    s = "ERROR";
+  } else if(level == RAD_LOG_WARN) {
+    s = "WARN";
+  } else if(level == RAD_LOG_INFO) {
+    s = "INFO";
+  } else if(level == RAD_LOG_DEBUG) {
+    s = "DEBUG";
+  }
+  return s;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Defines.h"
+
+// Log Levels
+#define RAD_LOG_NONE  0
+#define RAD_LOG_ERROR 1
+#define RAD_LOG_WARN  2
+#define RAD_LOG_INFO  3
+#define RAD_LOG_DEBUG 4
+
+#ifndef RAD_LOG_LEVEL
+#define RAD_LOG_LEVEL RAD_LOG_INFO
+#endif
+
+// Calls below RAD_LOG_LEVEL compile out completely, arguments included. The
+// format must be a string literal and is only expanded when the record is
+// read, so %s arguments have to outlive the ring (literals, feature ids).
+#if RAD_LOG_LEVEL >= RAD_LOG_ERROR
+#define RAD_ERROR(fmt, ...) RADLog::log(RAD_LOG_ERROR, "" fmt, ##__VA_ARGS__)
+#else
+#define RAD_ERROR(fmt, ...) do {} while(0)
+#endif
+
+#if RAD_LOG_LEVEL >= RAD_LOG_WARN
+#define RAD_WARN(fmt, ...) RADLog::log(RAD_LOG_WARN, "" fmt, ##__VA_ARGS__)
+#else
+#define RAD_WARN(fmt, ...) do {} while(0)
+#endif
+
+#if RAD_LOG_LEVEL >= RAD_LOG_INFO
+#define RAD_INFO(fmt, ...) RADLog::log(RAD_LOG_INFO, "" fmt, ##__VA_ARGS__)
+#else
+#define RAD_INFO(fmt, ...) do {} while(0)
+#endif
+
+#if RAD_LOG_LEVEL >= RAD_LOG_DEBUG
+#define RAD_DEBUG(fmt, ...) RADLog::log(RAD_LOG_DEBUG, "" fmt, ##__VA_ARGS__)
+#else
+#define RAD_DEBUG(fmt, ...) do {} while(0)
+#endif
+
+#define RAD_LOG_ARGS 3
+
+struct RADLogRecord {
+  unsigned long time;
+  const char* format;
+  uint8_t level;
+  uintptr_t args[RAD_LOG_ARGS];
+};
+
+// A RAM ring of the last RAD_LOG_SIZE records. Writing a record only copies
+// the format pointer and raw arguments, formatting happens when the ring is
+// fetched over HTTP or drained to the serial port.
+class RADLog {
+
+  private:
+
+    static RADLogRecord _records[RAD_LOG_SIZE];
+    static uint32_t _written;
+    static uint32_t _drained;
+
+    static void write(uint8_t level, const char* format, const uintptr_t* args, uint8_t count);
+
+  public:
+
+    template<typename... T>
+    static void log(uint8_t level, const char* format, T... args) {
+      static_assert(sizeof...(T) <= RAD_LOG_ARGS, "Too many log arguments");
+      const uintptr_t values[] = {0, (uintptr_t)args...};
+      write(level, format, values + 1, sizeof...(T));
+    };
+
+    static uint32_t getWritten() { return _written; };
+    static uint32_t getFirst();
+
+    // Formats record seq as a single line without the newline, returns false
+    // when it has already been overwritten
+    static bool format(uint32_t seq, char* buff, size_t len);
+
+    // Writes pending records to out while it can take them without blocking
+    static void drain(HardwareSerial& out, uint8_t max);
+
+    static const char* sendLevel(uint8_t level);
+
+};
@@ -0,0 +1,96 @@
+#include "RADSampler.h"
+
+
+RADSampler::RADSampler(ReadBoolFp func, unsigned long interval, unsigned long debounce) {
+  _readBool = func;
+  _readByte = NULL;
+  _interval = interval;
+  _deadband = 0;
+  _hysteresis = 0;
+  _debounce = debounce;
+  _sampled = false;
+  _lastSample = 0;
+  _reported = false;
+  _value = 0;
+  _direction = 0;
+  _pending = false;
+  _pendingSince = 0;
+}
+
+
+RADSampler::RADSampler(ReadByteFp func, unsigned long interval, uint8_t deadband,
+                       uint8_t hysteresis, unsigned long debounce) {
+  _readBool = NULL;
+  _readByte = func;
+  _interval = interval;
+  _deadband = deadband;
+  _hysteresis = hysteresis;
+  _debounce = debounce;
+  _sampled = false;
+  _lastSample = 0;
+  _reported = false;
+  _value = 0;
+  _direction = 0;
+  _pending = false;
+  _pendingSince = 0;
+}
+
+
+uint8_t RADSampler::read() {
+  uint8_t value = 0;
+  if(_readBool != NULL) {
+    // Match the payload encoding used by RADConnector::BuildPayload(bool)
+    value = _readBool() ? 255 : 0;
+  } else if(_readByte != NULL) {
+    value = _readByte();
+  }
+  return value;
+}
+
+
+bool RADSampler::significant(uint8_t value) {
+  if(value == _value) {
+    return false;
+  }
+  int8_t direction = value > _value ? 1 : -1;
+  int delta = value > _value ? value - _value : _value - value;
+  int threshold = _deadband;
+  if(_direction != 0 && direction != _direction) {
+    threshold += _hysteresis;
+  }
+  return delta > threshold;
+}
+
+
+bool RADSampler::sample(long current) {
+  if(_sampled && (unsigned long)(current - _lastSample) < _interval) {
+    return false;
+  }
+  _sampled = true;
+  _lastSample = current;
+  uint8_t value = read();
+
+  // Always report the first reading so subscribers learn the initial state
+  if(!_reported) {
+    _reported = true;
+    _value = value;
+    return true;
+  }
+
+  if(!significant(value)) {
+    _pending = false;
+    return false;
+  }
+  if(!_pending) {
+    _pending = true;
+    _pendingSince = current;
+  }
+  if((unsigned long)(current - _pendingSince) < _debounce) {
+    return false;
+  }
+
+  _pending = false;
+  _direction = value > _value ? 1 : -1;
+  _value = value;
+  return true;
+}
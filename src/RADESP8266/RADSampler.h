@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Defines.h"
+#include "Types.h"
+
+// Polls a sensor reader callback at a fixed interval and decides when a new
+// reading is significant enough to be reported as a State event.
+//
+// - deadband:   readings within +/- deadband of the last reported value are
+//               ignored.
+// - hysteresis: extra margin a reading must clear when it reverses the
+//               direction of the last reported change.
+// - debounce:   time in ms a significant reading must persist before it is
+//               reported.
+class RADSampler {
+
+  private:
+
+    ReadBoolFp _readBool;
+    ReadByteFp _readByte;
+    unsigned long _interval;
+    uint8_t _deadband;
+    uint8_t _hysteresis;
+    unsigned long _debounce;
+
+    bool _sampled;
+    long _lastSample;
+    bool _reported;
+    uint8_t _value;
+    int8_t _direction;
+    bool _pending;
+    long _pendingSince;
+
+    uint8_t read();
+    bool significant(uint8_t value);
+
+  public:
+
+    RADSampler(ReadBoolFp func, unsigned long interval, unsigned long debounce);
+    RADSampler(ReadByteFp func, unsigned long interval, uint8_t deadband,
+               uint8_t hysteresis, unsigned long debounce);
+
+    PayloadType getPayloadType() { return _readBool != NULL ? BoolPayload : BytePayload; };
+    bool hasValue() { return _reported; };
+    uint8_t getValue() { return _value; };
+
+    bool sample(long current);
+};
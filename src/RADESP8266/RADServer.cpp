@@ -0,0 +1,424 @@
+#include "RADServer.h"
+#include <strings.h>
+
+
+RADServer::RADServer(int port) : _server(port) {
+  _current = NULL;
+  _headerKeys = NULL;
+  _headerCount = 0;
+  _contentLength = CONTENT_LENGTH_NOT_SET;
+  _responded = false;
+  _chunked = false;
+  for(int i = 0; i < RAD_SERVER_MAX_CLIENTS; i++) {
+    _connections[i].active = false;
+  }
+}
+
+
+void RADServer::begin(void) {
+  _server.begin();
+  _server.setNoDelay(true);
+}
+
+
+void RADServer::on(const String& uri, THandlerFunction handler) {
+  RADRoute* route = new RADRoute();
+  route->uri = uri;
+  route->handler = handler;
+  _routes.add(route);
+}
+
+
+void RADServer::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+  _headerKeys = headerKeys;
+  _headerCount = headerKeysCount < RAD_SERVER_MAX_HEADERS ? headerKeysCount : RAD_SERVER_MAX_HEADERS;
+}
+
+
+void RADServer::handleClient(void) {
+  long current = millis();
+  accept(current);
+  RADConnection* connection;
+  for(int i = 0; i < RAD_SERVER_MAX_CLIENTS; i++) {
+    connection = &_connections[i];
+    if(!connection->active) {
+      continue;
+    }
+    if(read(connection)) {
+      connection->lastActive = current;
+    }
+    if(!connection->active) {
+      continue;
+    } else if(connection->state == RequestReady) {
+      dispatch(connection);
+    } else if(!connection->client.connected() ||
+              current - connection->lastActive > RAD_SERVER_IDLE_TIMEOUT) {
+      close(connection);
+    }
+  }
+}
+
+
+void RADServer::accept(long current) {
+  WiFiClient client = _server.available();
+  if(!client) {
+    return;
+  }
+  for(int i = 0; i < RAD_SERVER_MAX_CLIENTS; i++) {
+    if(!_connections[i].active) {
+      RADConnection* connection = &_connections[i];
+      connection->client = client;
+      connection->client.setNoDelay(true);
+      connection->active = true;
+      connection->lastActive = current;
+      reset(connection);
+      return;
+    }
+  }
+  // All connection slots are busy
+  client.print("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+  client.stop();
+}
+
+
+bool RADServer::read(RADConnection* connection) {
+  bool received = false;
+  WiFiClient& client = connection->client;
+  // Stop at the end of a request so pipelined requests stay in the socket
+  while(connection->active && connection->state != RequestReady && client.available() > 0) {
+    received = true;
+    if(connection->state == RequestBody) {
+      char buff[64];
+      size_t remaining = connection->contentLength - connection->body.length();
+      size_t len = remaining < sizeof(buff) ? remaining : sizeof(buff);
+      len = client.read((uint8_t*)buff, len);
+      for(size_t i = 0; i < len; i++) {
+        connection->body += buff[i];
+      }
+      if(connection->body.length() >= connection->contentLength) {
+        connection->state = RequestReady;
+      }
+      continue;
+    }
+    int c = client.read();
+    if(c < 0) {
+      break;
+    } else if(c == '\r') {
+      continue;
+    } else if(c != '\n') {
+      if(connection->lineLength + 1 >= sizeof(connection->line)) {
+        error(connection, connection->state == RequestLine ? 414 : 431);
+        break;
+      }
+      connection->line[connection->lineLength++] = (char)c;
+      continue;
+    }
+    connection->line[connection->lineLength] = '\0';
+    if(!parseLine(connection)) {
+      break;
+    }
+    connection->lineLength = 0;
+  }
+  return received;
+}
+
+
+bool RADServer::parseLine(RADConnection* connection) {
+  char* line = connection->line;
+  if(connection->state == RequestLine) {
+    // Tolerate empty lines between pipelined requests
+    if(connection->lineLength == 0) {
+      return true;
+    }
+    char* uri = strchr(line, ' ');
+    char* version = uri != NULL ? strchr(uri + 1, ' ') : NULL;
+    if(version == NULL) {
+      error(connection, 400);
+      return false;
+    }
+    *uri++ = '\0';
+    *version++ = '\0';
+    char* query = strchr(uri, '?');
+    if(query != NULL) {
+      *query = '\0';
+    }
+    if(strcmp(line, "GET") == 0) {
+      connection->method = HTTP_GET;
+    } else if(strcmp(line, "POST") == 0) {
+      connection->method = HTTP_POST;
+    } else if(strcmp(line, "PUT") == 0) {
+      connection->method = HTTP_PUT;
+    } else if(strcmp(line, "PATCH") == 0) {
+      connection->method = HTTP_PATCH;
+    } else if(strcmp(line, "DELETE") == 0) {
+      connection->method = HTTP_DELETE;
+    } else if(strcmp(line, "OPTIONS") == 0) {
+      connection->method = HTTP_OPTIONS;
+    } else {
+      connection->method = HTTP_ANY;
+    }
+    connection->uri = uri;
+    connection->http11 = strcmp(version, "HTTP/1.1") == 0;
+    connection->keepAlive = connection->http11;
+    connection->state = RequestHeaders;
+    return true;
+  }
+
+  // End of the headers
+  if(connection->lineLength == 0) {
+    if(connection->contentLength > RAD_SERVER_MAX_BODY) {
+      error(connection, 413);
+      return false;
+    }
+    connection->state = connection->contentLength > 0 ? RequestBody : RequestReady;
+    if(connection->state == RequestBody) {
+      connection->body.reserve(connection->contentLength);
+    }
+    return true;
+  }
+
+  char* value = strchr(line, ':');
+  if(value == NULL) {
+    error(connection, 400);
+    return false;
+  }
+  *value++ = '\0';
+  while(*value == ' ') {
+    value++;
+  }
+  if(strcasecmp(line, "Content-Length") == 0) {
+    connection->contentLength = strtoul(value, NULL, 10);
+  } else if(strcasecmp(line, "Transfer-Encoding") == 0) {
+    // Chunked request bodies are not supported
+    error(connection, 501);
+    return false;
+  } else if(strcasecmp(line, "Connection") == 0) {
+    if(strcasecmp(value, "close") == 0) {
+      connection->keepAlive = false;
+    } else if(strcasecmp(value, "keep-alive") == 0) {
+      connection->keepAlive = true;
+    }
+  }
+  for(size_t i = 0; i < _headerCount; i++) {
+    if(strcasecmp(line, _headerKeys[i]) == 0) {
+      connection->headers[i] = value;
+      break;
+    }
+  }
+  return true;
+}
+
+
+void RADServer::dispatch(RADConnection* connection) {
+  _current = connection;
+  _responseHeaders = "";
+  _contentLength = CONTENT_LENGTH_NOT_SET;
+  _responded = false;
+  _chunked = false;
+
+  THandlerFunction handler = _notFound;
+  RADRoute* route;
+  for(int i = 0; i < _routes.size(); i++) {
+    route = _routes.get(i);
+    if(route->uri == connection->uri) {
+      handler = route->handler;
+      break;
+    }
+  }
+  if(handler) {
+    handler();
+  }
+  if(!_responded) {
+    send(handler ? 500 : 404, "text/plain", "");
+  } else if(_chunked) {
+    connection->client.print("0\r\n\r\n");
+  }
+  _current = NULL;
+
+  if(connection->keepAlive) {
+    reset(connection);
+  } else {
+    close(connection);
+  }
+}
+
+
+void RADServer::reset(RADConnection* connection) {
+  connection->state = RequestLine;
+  connection->lineLength = 0;
+  connection->method = HTTP_ANY;
+  connection->uri = "";
+  connection->body = "";
+  connection->contentLength = 0;
+  connection->http11 = false;
+  connection->keepAlive = false;
+  for(int i = 0; i < RAD_SERVER_MAX_HEADERS; i++) {
+    connection->headers[i] = "";
+  }
+}
+
+
+void RADServer::close(RADConnection* connection) {
+  connection->client.stop();
+  connection->active = false;
+  connection->uri = "";
+  connection->body = "";
+}
+
+
+void RADServer::error(RADConnection* connection, int code) {
+  char buff[96];
+  snprintf(buff, sizeof(buff), "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+           code, statusText(code));
+  connection->client.print(buff);
+  close(connection);
+}
+
+
+String RADServer::uri(void) {
+  return _current != NULL ? _current->uri : String();
+}
+
+
+HTTPMethod RADServer::method(void) {
+  return _current != NULL ? _current->method : HTTP_ANY;
+}
+
+
+WiFiClient RADServer::client(void) {
+  return _current != NULL ? _current->client : WiFiClient();
+}
+
+
+const String& RADServer::arg(String name) {
+  static const String empty;
+  if(_current != NULL && name == "plain") {
+    return _current->body;
+  }
+  return empty;
+}
+
+
+bool RADServer::hasArg(String name) {
+  return _current != NULL && name == "plain" && _current->body.length() > 0;
+}
+
+
+String RADServer::header(String name) {
+  for(size_t i = 0; _current != NULL && i < _headerCount; i++) {
+    if(strcasecmp(name.c_str(), _headerKeys[i]) == 0) {
+      return _current->headers[i];
+    }
+  }
+  return String();
+}
+
+
+bool RADServer::hasHeader(String name) {
+  return header(name).length() > 0;
+}
+
+
+void RADServer::send(int code, const char* content_type, const String& content) {
+  if(_current == NULL || _responded) {
+    return;
+  }
+  _responded = true;
+  WiFiClient& client = _current->client;
+  char buff[128];
+  String head;
+  head.reserve(128 + _responseHeaders.length());
+  snprintf(buff, sizeof(buff), "HTTP/1.1 %d %s\r\n", code, statusText(code));
+  head += buff;
+  if(content_type != NULL && content_type[0] != '\0') {
+    head += "Content-Type: ";
+    head += content_type;
+    head += "\r\n";
+  }
+  if(_contentLength == CONTENT_LENGTH_UNKNOWN && _current->http11) {
+    _chunked = true;
+    head += "Transfer-Encoding: chunked\r\n";
+  } else if(_contentLength == CONTENT_LENGTH_UNKNOWN) {
+    // HTTP/1.0 has no chunked encoding, closing the connection ends the body
+    _current->keepAlive = false;
+  } else {
+    snprintf(buff, sizeof(buff), "Content-Length: %u\r\n",
+             (unsigned int)(_contentLength == CONTENT_LENGTH_NOT_SET ? content.length() : _contentLength));
+    head += buff;
+  }
+  head += _current->keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+  head += _responseHeaders;
+  head += "\r\n";
+  client.write((const uint8_t*)head.c_str(), head.length());
+  if(content.length() > 0) {
+    sendContent(content);
+  }
+}
+
+
+void RADServer::send(int code, char* content_type, const String& content) {
+  send(code, (const char*)content_type, content);
+}
+
+
+void RADServer::send(int code, const String& content_type, const String& content) {
+  send(code, content_type.c_str(), content);
+}
+
+
+void RADServer::sendHeader(const String& name, const String& value, bool first) {
+  String line = name;
+  line += ": ";
+  line += value;
+  line += "\r\n";
+  if(first) {
+    line += _responseHeaders;
+    _responseHeaders = line;
+  } else {
+    _responseHeaders += line;
+  }
+}
+
+
+void RADServer::setContentLength(size_t contentLength) {
+  _contentLength = contentLength;
+}
+
+
+void RADServer::sendContent(const String& content) {
+  if(_current == NULL || content.length() == 0) {
+    return;
+  }
+  WiFiClient& client = _current->client;
+  if(_chunked) {
+    char buff[12];
+    snprintf(buff, sizeof(buff), "%x\r\n", content.length());
+    client.print(buff);
+    client.write((const uint8_t*)content.c_str(), content.length());
+    client.print("\r\n");
+  } else {
+    client.write((const uint8_t*)content.c_str(), content.length());
+  }
+}
+
+
+const char* RADServer::statusText(int code) {
+  switch(code) {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 414: return "URI Too Long";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+  }
+  return "";
+}
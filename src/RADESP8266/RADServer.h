@@ -0,0 +1,120 @@
+#pragma once
+
+#include <ESP8266WebServer.h>
+#include <ESP8266WiFi.h>
+#include <FS.h>
+#include <LinkedList.h>
+#include "Defines.h"
+
+#ifndef CONTENT_LENGTH_NOT_SET
+#define CONTENT_LENGTH_NOT_SET ((size_t) -2)
+#endif
+
+// Parser States
+enum RADRequestState {
+    RequestLine    = 0,
+    RequestHeaders = 1,
+    RequestBody    = 2,
+    RequestReady   = 3
+};
+
+// A single persistent client connection and the request being parsed on it
+struct RADConnection {
+  WiFiClient client;
+  bool active;
+  RADRequestState state;
+  long lastActive;
+  char line[RAD_SERVER_MAX_LINE];
+  size_t lineLength;
+  HTTPMethod method;
+  String uri;
+  String body;
+  size_t contentLength;
+  bool http11;
+  bool keepAlive;
+  String headers[RAD_SERVER_MAX_HEADERS];
+};
+
+// Drop-in replacement for the subset of ESP8266WebServer used by
+// RADConnector. Up to RAD_SERVER_MAX_CLIENTS connections are kept open with
+// HTTP/1.1 keep-alive, requests are parsed incrementally as bytes arrive and
+// pipelined requests are answered in order, one per connection per call to
+// handleClient().
+class RADServer {
+
+  public:
+
+    typedef std::function<void(void)> THandlerFunction;
+
+  private:
+
+    struct RADRoute {
+      String uri;
+      THandlerFunction handler;
+    };
+
+    WiFiServer _server;
+    RADConnection _connections[RAD_SERVER_MAX_CLIENTS];
+    RADConnection* _current;
+    LinkedList<RADRoute*> _routes;
+    THandlerFunction _notFound;
+    const char** _headerKeys;
+    size_t _headerCount;
+
+    // Response state for the current request
+    String _responseHeaders;
+    size_t _contentLength;
+    bool _responded;
+    bool _chunked;
+
+    void accept(long current);
+    bool read(RADConnection* connection);
+    bool parseLine(RADConnection* connection);
+    void dispatch(RADConnection* connection);
+    void reset(RADConnection* connection);
+    void close(RADConnection* connection);
+    void error(RADConnection* connection, int code);
+
+  public:
+
+    RADServer(int port = RAD_HTTP_PORT);
+
+    void begin(void);
+    void handleClient(void);
+
+    void on(const String& uri, THandlerFunction handler);
+    void onNotFound(THandlerFunction handler) { _notFound = handler; };
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+
+    String uri(void);
+    HTTPMethod method(void);
+    WiFiClient client(void);
+    const String& arg(String name);
+    bool hasArg(String name);
+    String header(String name);
+    bool hasHeader(String name);
+
+    void send(int code, const char* content_type = NULL, const String& content = String(""));
+    void send(int code, char* content_type, const String& content);
+    void send(int code, const String& content_type, const String& content);
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(size_t contentLength);
+    void sendContent(const String& content);
+
+    template<typename T> size_t streamFile(T& file, const String& contentType) {
+      if(String(file.name()).endsWith(".gz")) {
+        sendHeader("Content-Encoding", "gzip");
+      }
+      setContentLength(file.size());
+      send(200, contentType, "");
+      uint8_t buff[256];
+      size_t total = 0;
+      size_t len;
+      while((len = file.read(buff, sizeof(buff))) > 0) {
+        total += _current->client.write((const uint8_t*)buff, len);
+      }
+      return total;
+    };
+
+    static const char* statusText(int code);
+};
@@ -0,0 +1,285 @@
+#include "RADSocket.h"
+#include <Hash.h>
+#include <strings.h>
+
+
+static const char WEBSOCKET_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+static const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+
+static void encode(const uint8_t* data, size_t len, char* out) {
+  // Padded base64, out must hold 4 * ((len + 2) / 3) + 1 bytes
+  for(size_t i = 0; i < len; i += 3) {
+    uint32_t n = (uint32_t)data[i] << 16;
+    if(i + 1 < len) {
+      n |= (uint32_t)data[i + 1] << 8;
+    }
+    if(i + 2 < len) {
+      n |= data[i + 2];
+    }
+    *out++ = BASE64[(n >> 18) & 0x3f];
+    *out++ = BASE64[(n >> 12) & 0x3f];
+    *out++ = i + 1 < len ? BASE64[(n >> 6) & 0x3f] : '=';
+    *out++ = i + 2 < len ? BASE64[n & 0x3f] : '=';
+  }
+  *out = '\0';
+}
+
+
+RADSocket::RADSocket(int port) : _server(port) {
+  for(int i = 0; i < RAD_WEBSOCKET_MAX_CLIENTS; i++) {
+    _clients[i].active = false;
+  }
+}
+
+
+void RADSocket::begin(void) {
+  _server.begin();
+  _server.setNoDelay(true);
+}
+
+
+bool RADSocket::update(void) {
+  long current = millis();
+  bool received = false;
+  accept(current);
+  RADSocketClient* client;
+  for(uint8_t i = 0; i < RAD_WEBSOCKET_MAX_CLIENTS; i++) {
+    client = &_clients[i];
+    if(!client->active) {
+      continue;
+    }
+    if(read(i)) {
+      client->lastActive = current;
+      received = true;
+    }
+    if(client->active && (!client->client.connected() ||
+                          current - client->lastActive > RAD_WEBSOCKET_IDLE_TIMEOUT)) {
+      client->client.stop();
+      client->active = false;
+    }
+  }
+  return received;
+}
+
+
+void RADSocket::accept(long current) {
+  WiFiClient incoming = _server.available();
+  if(!incoming) {
+    return;
+  }
+  RADSocketClient* client;
+  for(int i = 0; i < RAD_WEBSOCKET_MAX_CLIENTS; i++) {
+    client = &_clients[i];
+    if(!client->active) {
+      client->client = incoming;
+      client->client.setNoDelay(true);
+      client->active = true;
+      client->open = false;
+      client->binary = false;
+      client->lastActive = current;
+      client->lineLength = 0;
+      client->key[0] = '\0';
+      client->frameLength = 0;
+      memset(client->watched, 0, sizeof(client->watched));
+      return;
+    }
+  }
+  // All socket slots are busy
+  incoming.print("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+  incoming.stop();
+}
+
+
+bool RADSocket::read(uint8_t index) {
+  RADSocketClient* client = &_clients[index];
+  WiFiClient& wifi = client->client;
+  bool received = false;
+
+  // Upgrade request, one line at a time
+  while(client->active && !client->open && wifi.available() > 0) {
+    received = true;
+    int c = wifi.read();
+    if(c < 0) {
+      break;
+    } else if(c == '\r') {
+      continue;
+    } else if(c != '\n') {
+      if(client->lineLength + 1 >= sizeof(client->line)) {
+        wifi.print("HTTP/1.1 431 Request Header Fields Too Large\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        wifi.stop();
+        client->active = false;
+        break;
+      }
+      client->line[client->lineLength++] = (char)c;
+      continue;
+    }
+    client->line[client->lineLength] = '\0';
+    if(!handshake(client)) {
+      break;
+    }
+    client->lineLength = 0;
+  }
+
+  // Frames, never reading past the end of the current one. Until the
+  // length is known only the fixed part of the header is asked for
+  uint8_t* frame = client->frame;
+  while(client->active && client->open) {
+    size_t header = 2;
+    size_t payload = 0;
+    if(client->frameLength >= 2) {
+      uint8_t len = frame[1] & 0x7f;
+      header = len == 126 ? 8 : 6;
+      if(len < 126) {
+        payload = len;
+      } else if(len == 126 && client->frameLength >= 4) {
+        payload = ((size_t)frame[2] << 8) | frame[3];
+      }
+      if(!(frame[1] & 0x80)) {
+        close(client, 1002);
+        break;
+      } else if(!(frame[0] & 0x80) || (frame[0] & 0x0f) == ContinuationFrame) {
+        close(client, 1003);
+        break;
+      } else if(len == 127 || payload > RAD_WEBSOCKET_MAX_FRAME) {
+        close(client, 1009);
+        break;
+      }
+    }
+    if(client->frameLength < header + payload) {
+      if(wifi.available() <= 0) {
+        break;
+      }
+      int n = wifi.read(frame + client->frameLength, header + payload - client->frameLength);
+      if(n <= 0) {
+        break;
+      }
+      received = true;
+      client->frameLength += n;
+      continue;
+    }
+
+    uint8_t opcode = frame[0] & 0x0f;
+    uint8_t* mask = frame + header - 4;
+    uint8_t* data = frame + header;
+    for(size_t i = 0; i < payload; i++) {
+      data[i] ^= mask[i & 3];
+    }
+    data[payload] = '\0';
+    client->frameLength = 0;
+    switch(opcode) {
+      case TextFrame:
+      case BinaryFrame:
+        client->binary = opcode == BinaryFrame;
+        if(_frame) {
+          _frame(index, client->binary, data, payload);
+        }
+        break;
+      case PingFrame:
+        write(client, PongFrame, data, payload);
+        break;
+      case CloseFrame:
+        write(client, CloseFrame, data, payload >= 2 ? 2 : 0);
+        wifi.stop();
+        client->active = false;
+        break;
+    }
+  }
+  return received;
+}
+
+
+void RADSocket::write(RADSocketClient* client, uint8_t opcode, const uint8_t* data, size_t len) {
+  // Server frames are not masked, the header goes out together with the
+  // payload whenever it fits
+  uint8_t buff[4 + RAD_WEBSOCKET_MAX_FRAME];
+  size_t header = 2;
+  buff[0] = 0x80 | opcode;
+  if(len < 126) {
+    buff[1] = len;
+  } else {
+    buff[1] = 126;
+    buff[2] = len >> 8;
+    buff[3] = len & 0xff;
+    header = 4;
+  }
+  if(len <= RAD_WEBSOCKET_MAX_FRAME) {
+    memcpy(buff + header, data, len);
+    client->client.write(buff, header + len);
+  } else {
+    client->client.write(buff, header);
+    client->client.write(data, len);
+  }
+}
+
+
+void RADSocket::close(RADSocketClient* client, uint16_t status) {
+  uint8_t data[2] = {(uint8_t)(status >> 8), (uint8_t)(status & 0xff)};
+  write(client, CloseFrame, data, sizeof(data));
+  client->client.stop();
+  client->active = false;
+}
+
+
+bool RADSocket::handshake(RADSocketClient* client) {
+  char* line = client->line;
+  if(client->lineLength > 0) {
+    // Only the key is needed, the request line and other headers are skipped
+    char* value = strchr(line, ':');
+    if(value != NULL) {
+      *value++ = '\0';
+      while(*value == ' ') {
+        value++;
+      }
+      if(strcasecmp(line, "Sec-WebSocket-Key") == 0 && strlen(value) < sizeof(client->key)) {
+        strcpy(client->key, value);
+      }
+    }
+    return true;
+  }
+  if(client->key[0] == '\0') {
+    client->client.print("HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    client->client.stop();
+    client->active = false;
+    return false;
+  }
+  char buff[sizeof(client->key) + sizeof(WEBSOCKET_GUID)];
+  uint8_t hash[20];
+  char accept[29];
+  snprintf(buff, sizeof(buff), "%s%s", client->key, WEBSOCKET_GUID);
+  sha1((const uint8_t*)buff, strlen(buff), hash);
+  encode(hash, sizeof(hash), accept);
+  char response[160];
+  snprintf(response, sizeof(response),
+           "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+           "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+  client->client.write((const uint8_t*)response, strlen(response));
+  client->open = true;
+  return true;
+}
+
+
+bool RADSocket::send(uint8_t client, bool binary, const uint8_t* data, size_t len) {
+  if(client >= RAD_WEBSOCKET_MAX_CLIENTS || !_clients[client].active ||
+     !_clients[client].open || len > 0xffff) {
+    return false;
+  }
+  write(&_clients[client], binary ? BinaryFrame : TextFrame, data, len);
+  return true;
+}
+
+
+void RADSocket::watch(uint8_t client, int feature) {
+  if(client < RAD_WEBSOCKET_MAX_CLIENTS && feature >= 0 && feature < RAD_WEBSOCKET_MAX_FEATURES) {
+    _clients[client].watched[feature / 8] |= 1 << (feature % 8);
+  }
+}
+
+
+bool RADSocket::isWatching(uint8_t client, int feature) {
+  if(client >= RAD_WEBSOCKET_MAX_CLIENTS || feature < 0 || feature >= RAD_WEBSOCKET_MAX_FEATURES) {
+    return false;
+  }
+  RADSocketClient* c = &_clients[client];
+  return c->active && c->open && (c->watched[feature / 8] & (1 << (feature % 8))) != 0;
+}
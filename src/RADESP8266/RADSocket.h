@@ -0,0 +1,74 @@
+#pragma once
+
+#include <ESP8266WiFi.h>
+#include <functional>
+#include "Defines.h"
+
+// Frame Opcodes
+enum RADSocketOpcode {
+    ContinuationFrame = 0x0,
+    TextFrame         = 0x1,
+    BinaryFrame       = 0x2,
+    CloseFrame        = 0x8,
+    PingFrame         = 0x9,
+    PongFrame         = 0xa
+};
+
+// A single WebSocket client, the handshake and then each frame are buffered
+// until complete
+struct RADSocketClient {
+  WiFiClient client;
+  bool active;
+  bool open;
+  bool binary;
+  long lastActive;
+  char line[RAD_SERVER_MAX_LINE];
+  size_t lineLength;
+  char key[32];
+  uint8_t frame[RAD_WEBSOCKET_MAX_FRAME + 9];   // 8 byte header and a NUL
+  size_t frameLength;
+  uint8_t watched[(RAD_WEBSOCKET_MAX_FEATURES + 7) / 8];
+};
+
+// Minimal RFC 6455 server for the command channel. Up to
+// RAD_WEBSOCKET_MAX_CLIENTS sockets are kept open, each frame is handed to
+// the frame handler once it has fully arrived, unmasked and NUL terminated.
+// Fragmented messages and frames over RAD_WEBSOCKET_MAX_FRAME are refused
+// with a close frame. Pings are answered here, everything else is up to the
+// handler.
+class RADSocket {
+
+  public:
+
+    typedef std::function<void(uint8_t client, bool binary, uint8_t* data, size_t len)> TFrameFunction;
+
+  private:
+
+    WiFiServer _server;
+    RADSocketClient _clients[RAD_WEBSOCKET_MAX_CLIENTS];
+    TFrameFunction _frame;
+
+    void accept(long current);
+    bool handshake(RADSocketClient* client);
+    bool read(uint8_t index);
+    void write(RADSocketClient* client, uint8_t opcode, const uint8_t* data, size_t len);
+    void close(RADSocketClient* client, uint16_t status);
+
+  public:
+
+    RADSocket(int port = RAD_WEBSOCKET_PORT);
+
+    void begin(void);
+    // Returns true when any frame was handled
+    bool update(void);
+
+    void onFrame(TFrameFunction handler) { _frame = handler; };
+    bool send(uint8_t client, bool binary, const uint8_t* data, size_t len);
+
+    // Features are tracked by index, a client only receives events for the
+    // features it has watched
+    void watch(uint8_t client, int feature);
+    bool isWatching(uint8_t client, int feature);
+    bool isBinary(uint8_t client) { return _clients[client].binary; };
+    IPAddress remoteIP(uint8_t client) { return _clients[client].client.remoteIP(); };
+};
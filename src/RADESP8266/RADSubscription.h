@@ -23,6 +23,20 @@ class RADSubscription {
     int _calls;
     int _errors;
 
+    // Filter and the values it was last evaluated against
+    FilterType _filter;
+    uint8_t _threshold;
+    int _interval;
+    bool _seen;
+    uint8_t _lastSeen;
+    bool _notified;
+    uint8_t _lastValue;
+    long _lastNotify;
+    // Latest value held back by the interval, sent once it has passed
+    bool _pending;
+    EventType _pendingType;
+    uint8_t _pendingValue;
+
   public:
 
     RADSubscription(RADFeature* feature, const char* sid, EventType type,
@@ -35,6 +49,17 @@ class RADSubscription {
       _end = _started + timeout * 1000;
       _calls = calls;
       _errors = errors;
+      _filter = NullFilter;
+      _threshold = 0;
+      _interval = 0;
+      _seen = false;
+      _lastSeen = 0;
+      _notified = false;
+      _lastValue = 0;
+      _lastNotify = 0;
+      _pending = false;
+      _pendingType = NullEvent;
+      _pendingValue = 0;
       strncpy(_sid, sid, sizeof(_sid));
       strncpy(_callback, callback, sizeof(_callback));
     };
@@ -43,8 +68,82 @@ class RADSubscription {
     char* getCallback() { return _callback; };
     int getTimeout() { return _timeout; };
     int getDuration(long current) { return (current - _started) / 1000; }
+    long getRemaining(long current) { return _end - current; }
+    void setRemaining(long current, long remaining) {
+      _end = current + remaining;
+      _started = _end - _timeout * 1000L;
+    }
     RADFeature* getFeature() { return _feature; };
+    int getCalls() { return _calls; };
+    int getErrors() { return _errors; };
+    void success() {
+      _calls += 1;
+      _errors = 0;
+    }
+    void failure() {
+      _calls += 1;
+      _errors += 1;
+    }
     bool isActive(long current) {
-      return _end > current;
+      return _end > current && _errors < RAD_MAX_SUBSCRIPTION_ERRORS;
+    }
+    void filter(FilterType filter, uint8_t threshold, int interval) {
+      _filter = filter;
+      _threshold = threshold;
+      _interval = interval;
+    }
+    FilterType getFilter() { return _filter; };
+    uint8_t getThreshold() { return _threshold; };
+    int getInterval() { return _interval; };
+
+    // Decides whether an event is sent to this subscriber, evaluated before
+    // any HTTP work. Predicates only apply to events that carry a value.
+    bool accepts(EventType type, bool has_value, uint8_t value, long current) {
+      if(_type != All && _type != type) {
+        return false;
+      }
+      bool result = true;
+      if(has_value) {
+        switch(_filter) {
+          case EqualsFilter:
+            result = value == _threshold;
+            break;
+          case CrossesFilter:
+            // The first value seen only sets which side of the threshold we are on
+            result = _seen && (_lastSeen < _threshold) != (value < _threshold);
+            break;
+          case ChangedFilter:
+            result = !_notified || value != _lastValue;
+            break;
+          case NullFilter:
+            break;
+        }
+        _seen = true;
+        _lastSeen = value;
+        // A later value the filter rejects supersedes one held back earlier
+        _pending = false;
+      }
+      if(result && _notified && _interval > 0 && current - _lastNotify < _interval * 1000L) {
+        if(has_value) {
+          _pending = true;
+          _pendingType = type;
+          _pendingValue = value;
+        }
+        result = false;
+      }
+      return result;
+    }
+    void notified(bool has_value, uint8_t value, long current) {
+      _notified = true;
+      _lastNotify = current;
+      _pending = false;
+      if(has_value) {
+        _lastValue = value;
+      }
+    }
+    bool isDue(long current) {
+      return _pending && current - _lastNotify >= _interval * 1000L;
     }
+    EventType getPendingType() { return _pendingType; };
+    uint8_t getPendingValue() { return _pendingValue; };
 };
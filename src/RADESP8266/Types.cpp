@@ -42,6 +42,17 @@ CommandType getCommandType(const char* s) {
 }
 
 
+CommandType getCommandType(const char* s, size_t len) {
+  CommandType ct = NullCommand;
+  if(len == 3 && strncmp(s, "Get", len) == 0) {
+    ct = Get;
+  } else if(len == 3 && strncmp(s, "Set", len) == 0) {
+    ct = Set;
+  }
+  return ct;
+}
+
+
 const char* sendCommandType(CommandType ct) {
   const char* s = "NullCommand";
   if(ct == Get) {
@@ -61,6 +72,8 @@ EventType getEventType(const char* s) {
     et = Start;
   } else if(strcmp(s, "State") == 0) {
     et = State;
+  } else if(strcmp(s, "Complete") == 0) {
+    et = Complete;
   }
   return et;
 }
@@ -74,7 +87,53 @@ const char* sendEventType(EventType et) {
     s = "Start";
   } else if(et == State) {
     s = "State";
+  } else if(et == Complete) {
+    s = "Complete";
   }
   return s;
 }
 
+
+FilterType getFilterType(const char* s) {
+  FilterType ft = NullFilter;
+  if(strcmp(s, "Equals") == 0) {
+    ft = EqualsFilter;
+  } else if(strcmp(s, "Crosses") == 0) {
+    ft = CrossesFilter;
+  } else if(strcmp(s, "Changed") == 0) {
+    ft = ChangedFilter;
+  }
+  return ft;
+}
+
+
+const char* sendFilterType(FilterType ft) {
+  const char* s = "NullFilter";
+  if(ft == EqualsFilter) {
+    s = "Equals";
+  } else if(ft == CrossesFilter) {
+    s = "Crosses";
+  } else if(ft == ChangedFilter) {
+    s = "Changed";
+  }
+  return s;
+}
+
+
+uint32_t crc32(uint32_t crc, const void* data, size_t len) {
+  // Nibble-wise CRC-32 (IEEE 802.3), call with crc = 0 to start
+  static const uint32_t table[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+    0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+  };
+  const uint8_t* p = (const uint8_t*)data;
+  crc = ~crc;
+  while(len--) {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ table[crc & 0x0f];
+    crc = (crc >> 4) ^ table[crc & 0x0f];
+  }
+  return ~crc;
+}
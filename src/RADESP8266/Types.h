@@ -28,7 +28,16 @@ enum EventType {
     NullEvent  = 0,
     All        = 1,
     Start      = 2,
-    State      = 3
+    State      = 3,
+    Complete   = 4
+};
+
+// Subscription Filters
+enum FilterType {
+    NullFilter    = 0,
+    EqualsFilter  = 1,
+    CrossesFilter = 2,
+    ChangedFilter = 3
 };
 
 // Payload Types
@@ -49,17 +58,25 @@ struct RADPayload {
   uint8_t* data;
 };
 
-// Callback Definitions
+// Callback Definitions, Get callbacks should return a payload created with
+// RADConnector::BuildPayload() and the library takes ownership of it
 typedef bool (* TriggerFp)();
 typedef bool (* SetBoolFp)(bool);
 typedef bool (* SetByteFp)(uint8_t);
 typedef bool (* SetByteArrayFp)(uint8_t*, uint8_t);
 typedef RADPayload* (* GetFp)(void);
+typedef bool (* ReadBoolFp)(void);
+typedef uint8_t (* ReadByteFp)(void);
 
 
 FeatureType getFeatureType(const char* s);
 const char* sendFeatureType(FeatureType ft);
 CommandType getCommandType(const char* s);
+CommandType getCommandType(const char* s, size_t len);
 const char* sendCommandType(CommandType ct);
 EventType getEventType(const char* s);
 const char* sendEventType(EventType et);
+FilterType getFilterType(const char* s);
+const char* sendFilterType(FilterType ft);
+
+uint32_t crc32(uint32_t crc, const void* data, size_t len);